@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitonic_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define BITONIC_X86 1
+#endif
+
+// ---------------------------------------------------------------------------
+// Scalar reference kernels
+// ---------------------------------------------------------------------------
+
+static inline void compare_exchange(int *lo, int *hi) {
+    int a = *lo, b = *hi;
+    *lo = (a < b) ? a : b;
+    *hi = (a < b) ? b : a;
+}
+
+static void scalar_span(int *lo, int *hi, long len) {
+    for (long t = 0; t < len; t++) {
+        compare_exchange(&lo[t], &hi[t]);
+    }
+}
+
+static void scalar_span_mirror(int *lo, int *hi_end, long len) {
+    for (long t = 0; t < len; t++) {
+        compare_exchange(&lo[t], &hi_end[-t]);
+    }
+}
+
+// Pairs of stage (k, j) in the blocks starting at `from` (a multiple of
+// 2*j), skipping pairs whose upper element lies at or beyond n
+static void scalar_stage_tail(int *arr, int n, long from, int j, int flip) {
+    long block = 2L * j;
+    for (long base = from; base < n; base += block) {
+        for (long off = 0; off < j; off++) {
+            long hi = flip ? base + block - 1 - off : base + off + j;
+            if (hi < n) {
+                compare_exchange(&arr[base + off], &arr[hi]);
+            }
+        }
+    }
+}
+
+static const bitonic_kernels_t scalar_kernels = {
+    "scalar", 1, scalar_span, scalar_span_mirror, NULL
+};
+
+#ifdef BITONIC_X86
+
+// Per-stage lane tables for the in-register kernels. Lane i is paired with
+// i ^ j (regular stage) or i ^ (2*j - 1) (mirrored stage) and keeps the
+// maximum when bit j of i is set, the minimum otherwise.
+static void build_lane_tables(int width, int k, int j, int *partner, int *upper) {
+    int mask = (j == k >> 1) ? 2 * j - 1 : j;
+    for (int i = 0; i < width; i++) {
+        partner[i] = i ^ mask;
+        upper[i] = (i & j) ? -1 : 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// SSE4.1: 4 x int32
+// ---------------------------------------------------------------------------
+
+__attribute__((target("sse4.1")))
+static void sse41_span(int *lo, int *hi, long len) {
+    long t = 0;
+    for (; t + 4 <= len; t += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(lo + t));
+        __m128i b = _mm_loadu_si128((const __m128i *)(hi + t));
+        _mm_storeu_si128((__m128i *)(lo + t), _mm_min_epi32(a, b));
+        _mm_storeu_si128((__m128i *)(hi + t), _mm_max_epi32(a, b));
+    }
+    scalar_span(lo + t, hi + t, len - t);
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_span_mirror(int *lo, int *hi_end, long len) {
+    long t = 0;
+    for (; t + 4 <= len; t += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(lo + t));
+        __m128i b = _mm_loadu_si128((const __m128i *)(hi_end - t - 3));
+        b = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 1, 2, 3));
+        __m128i mx = _mm_max_epi32(a, b);
+        _mm_storeu_si128((__m128i *)(lo + t), _mm_min_epi32(a, b));
+        _mm_storeu_si128((__m128i *)(hi_end - t - 3), _mm_shuffle_epi32(mx, _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+    scalar_span_mirror(lo + t, hi_end - t, len - t);
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_chunk_stage(int *arr, long chunks, int k, int j) {
+    int partner[4], upper[4];
+    build_lane_tables(4, k, j, partner, upper);
+
+    // Byte shuffle moving each lane's partner into place
+    unsigned char bytes[16];
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 4; b++) {
+            bytes[i * 4 + b] = (unsigned char)(partner[i] * 4 + b);
+        }
+    }
+    __m128i shuffle = _mm_loadu_si128((const __m128i *)bytes);
+    __m128i keep_max = _mm_loadu_si128((const __m128i *)upper);
+
+    for (long c = 0; c < chunks; c++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(arr + c * 4));
+        __m128i p = _mm_shuffle_epi8(v, shuffle);
+        __m128i r = _mm_blendv_epi8(_mm_min_epi32(v, p), _mm_max_epi32(v, p), keep_max);
+        _mm_storeu_si128((__m128i *)(arr + c * 4), r);
+    }
+}
+
+static const bitonic_kernels_t sse41_kernels = {
+    "sse4.1", 4, sse41_span, sse41_span_mirror, sse41_chunk_stage
+};
+
+// ---------------------------------------------------------------------------
+// AVX2: 8 x int32
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void avx2_span(int *lo, int *hi, long len) {
+    long t = 0;
+    for (; t + 8 <= len; t += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(lo + t));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(hi + t));
+        _mm256_storeu_si256((__m256i *)(lo + t), _mm256_min_epi32(a, b));
+        _mm256_storeu_si256((__m256i *)(hi + t), _mm256_max_epi32(a, b));
+    }
+    scalar_span(lo + t, hi + t, len - t);
+}
+
+__attribute__((target("avx2")))
+static void avx2_span_mirror(int *lo, int *hi_end, long len) {
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    long t = 0;
+    for (; t + 8 <= len; t += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(lo + t));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(hi_end - t - 7));
+        b = _mm256_permutevar8x32_epi32(b, reverse);
+        __m256i mx = _mm256_max_epi32(a, b);
+        _mm256_storeu_si256((__m256i *)(lo + t), _mm256_min_epi32(a, b));
+        _mm256_storeu_si256((__m256i *)(hi_end - t - 7), _mm256_permutevar8x32_epi32(mx, reverse));
+    }
+    scalar_span_mirror(lo + t, hi_end - t, len - t);
+}
+
+__attribute__((target("avx2")))
+static void avx2_chunk_stage(int *arr, long chunks, int k, int j) {
+    int partner[8], upper[8];
+    build_lane_tables(8, k, j, partner, upper);
+    __m256i index = _mm256_loadu_si256((const __m256i *)partner);
+    __m256i keep_max = _mm256_loadu_si256((const __m256i *)upper);
+
+    for (long c = 0; c < chunks; c++) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(arr + c * 8));
+        __m256i p = _mm256_permutevar8x32_epi32(v, index);
+        __m256i r = _mm256_blendv_epi8(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), keep_max);
+        _mm256_storeu_si256((__m256i *)(arr + c * 8), r);
+    }
+}
+
+static const bitonic_kernels_t avx2_kernels = {
+    "avx2", 8, avx2_span, avx2_span_mirror, avx2_chunk_stage
+};
+
+// ---------------------------------------------------------------------------
+// AVX-512F: 16 x int32
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f")))
+static void avx512_span(int *lo, int *hi, long len) {
+    long t = 0;
+    for (; t + 16 <= len; t += 16) {
+        __m512i a = _mm512_loadu_si512((const void *)(lo + t));
+        __m512i b = _mm512_loadu_si512((const void *)(hi + t));
+        _mm512_storeu_si512((void *)(lo + t), _mm512_min_epi32(a, b));
+        _mm512_storeu_si512((void *)(hi + t), _mm512_max_epi32(a, b));
+    }
+    scalar_span(lo + t, hi + t, len - t);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_span_mirror(int *lo, int *hi_end, long len) {
+    const __m512i reverse = _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8,
+                                              7, 6, 5, 4, 3, 2, 1, 0);
+    long t = 0;
+    for (; t + 16 <= len; t += 16) {
+        __m512i a = _mm512_loadu_si512((const void *)(lo + t));
+        __m512i b = _mm512_loadu_si512((const void *)(hi_end - t - 15));
+        b = _mm512_permutexvar_epi32(reverse, b);
+        __m512i mx = _mm512_max_epi32(a, b);
+        _mm512_storeu_si512((void *)(lo + t), _mm512_min_epi32(a, b));
+        _mm512_storeu_si512((void *)(hi_end - t - 15), _mm512_permutexvar_epi32(reverse, mx));
+    }
+    scalar_span_mirror(lo + t, hi_end - t, len - t);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_chunk_stage(int *arr, long chunks, int k, int j) {
+    int partner[16], upper[16];
+    build_lane_tables(16, k, j, partner, upper);
+    __m512i index = _mm512_loadu_si512((const void *)partner);
+    __mmask16 keep_max = 0;
+    for (int i = 0; i < 16; i++) {
+        if (upper[i]) keep_max |= (__mmask16)(1u << i);
+    }
+
+    for (long c = 0; c < chunks; c++) {
+        __m512i v = _mm512_loadu_si512((const void *)(arr + c * 16));
+        __m512i p = _mm512_permutexvar_epi32(index, v);
+        __m512i r = _mm512_mask_blend_epi32(keep_max, _mm512_min_epi32(v, p), _mm512_max_epi32(v, p));
+        _mm512_storeu_si512((void *)(arr + c * 16), r);
+    }
+}
+
+static const bitonic_kernels_t avx512_kernels = {
+    "avx512", 16, avx512_span, avx512_span_mirror, avx512_chunk_stage
+};
+
+// ---------------------------------------------------------------------------
+// Runtime ISA detection (cpuid + xgetbv for OS-enabled register state)
+// ---------------------------------------------------------------------------
+
+static unsigned long long read_xcr0(void) {
+    unsigned int eax, edx;
+    __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+}
+
+static int cpu_supports(const bitonic_kernels_t *kernels) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+    int has_sse41 = (ecx & bit_SSE4_1) != 0;
+    int has_osxsave = (ecx & bit_OSXSAVE) != 0;
+    if (kernels == &sse41_kernels) return has_sse41;
+
+    if (!has_osxsave) return 0;
+    unsigned long long xcr0 = read_xcr0();
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+
+    // XMM and YMM state must be enabled by the OS
+    if (kernels == &avx2_kernels) {
+        return (ebx & bit_AVX2) && (xcr0 & 0x6) == 0x6;
+    }
+    // Additionally opmask and ZMM state
+    if (kernels == &avx512_kernels) {
+        return (ebx & bit_AVX512F) && (xcr0 & 0xE6) == 0xE6;
+    }
+    return 0;
+}
+
+static const bitonic_kernels_t *all_kernels[] = {
+    &avx512_kernels, &avx2_kernels, &sse41_kernels, &scalar_kernels
+};
+
+#else
+
+static int cpu_supports(const bitonic_kernels_t *kernels) {
+    return kernels == &scalar_kernels;
+}
+
+static const bitonic_kernels_t *all_kernels[] = {
+    &scalar_kernels
+};
+
+#endif
+
+#define NUM_KERNEL_SETS ((int)(sizeof(all_kernels) / sizeof(all_kernels[0])))
+
+const bitonic_kernels_t *bitonic_select_kernels(const char *name) {
+    int want_auto = (name == NULL || strcmp(name, "auto") == 0);
+
+    // all_kernels is ordered widest first, so "auto" picks the best supported
+    for (int i = 0; i < NUM_KERNEL_SETS; i++) {
+        const bitonic_kernels_t *kernels = all_kernels[i];
+        if (!want_auto && strcmp(name, kernels->name) != 0) continue;
+        if (kernels == &scalar_kernels || cpu_supports(kernels)) {
+            return kernels;
+        }
+        if (!want_auto) return NULL;
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Stage execution
+// ---------------------------------------------------------------------------
+
+// Every stage groups its pairs into blocks of 2*j elements with j pairs per
+// block. Pairs whose upper element falls at or beyond n would compare
+// against a virtual INT_MAX pad and never swap, so they are simply skipped.
+// Full blocks contribute j pairs each, the trailing partial block of
+// r = n % (2*j) elements contributes max(r - j, 0).
+long bitonic_stage_pairs(int n, int j) {
+    long block = 2L * j;
+    long full_blocks = n / block;
+    long remainder = n % block;
+    long partial = remainder > j ? remainder - j : 0;
+    return full_blocks * j + partial;
+}
+
+void bitonic_stage(const bitonic_kernels_t *kernels, int *arr, int n, int k, int j,
+                   int thread_id, int num_threads) {
+    int flip = (j == k >> 1);
+    long block = 2L * j;
+
+    // Small strides: whole pairs sit inside aligned vector chunks, so the
+    // threads split chunks and shuffle in registers; the last thread takes
+    // the partial chunk at the end with the scalar kernel
+    if (kernels->chunk_stage && block <= kernels->width) {
+        int width = kernels->width;
+        long chunks = n / width;
+        long chunks_per_thread = (chunks + num_threads - 1) / num_threads;
+        long first = (long)thread_id * chunks_per_thread;
+        long last = first + chunks_per_thread;
+        if (first > chunks) first = chunks;
+        if (last > chunks) last = chunks;
+        if (last > first) {
+            kernels->chunk_stage(arr + first * width, last - first, k, j);
+        }
+        if (thread_id == num_threads - 1) {
+            scalar_stage_tail(arr, n, chunks * width, j, flip);
+        }
+        return;
+    }
+
+    // Large strides: split the live pairs into contiguous ranges
+    long num_pairs = bitonic_stage_pairs(n, j);
+    long pairs_per_thread = (num_pairs + num_threads - 1) / num_threads;
+    long p = (long)thread_id * pairs_per_thread;
+    long pair_end = p + pairs_per_thread;
+    if (pair_end > num_pairs) pair_end = num_pairs;
+
+    long full_pairs = (n / block) * j;
+    long remainder = n % block;
+
+    // Walk this thread's pairs as contiguous spans inside one block
+    while (p < pair_end) {
+        long base, off, span;
+        if (p < full_pairs) {
+            base = (p / j) * block;
+            off = p % j;
+            span = j - off;
+        } else {
+            // Trailing partial block: only pairs with upper element < n
+            base = (n / block) * block;
+            off = (flip ? block - remainder : 0) + (p - full_pairs);
+            span = pair_end - p;
+        }
+        if (span > pair_end - p) span = pair_end - p;
+
+        if (flip) {
+            kernels->span_mirror(arr + base + off, arr + base + block - 1 - off, span);
+        } else {
+            kernels->span(arr + base + off, arr + base + off + j, span);
+        }
+        p += span;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Self-test
+// ---------------------------------------------------------------------------
+
+// Whole network run stage by stage, emulating num_threads sequentially
+static void run_network(const bitonic_kernels_t *kernels, int *arr, int n, int num_threads) {
+    int top = 1;
+    while (top < n) top *= 2;
+    for (int k = 2; k <= top; k <<= 1) {
+        for (int j = k >> 1; j > 0; j >>= 1) {
+            for (int t = 0; t < num_threads; t++) {
+                bitonic_stage(kernels, arr, n, k, j, t, num_threads);
+            }
+        }
+    }
+}
+
+int bitonic_kernels_selftest(int max_n) {
+    int failures = 0;
+    int *input = malloc((max_n + 1) * sizeof(int));
+    int *expected = malloc((max_n + 1) * sizeof(int));
+    int *actual = malloc((max_n + 1) * sizeof(int));
+    if (!input || !expected || !actual) {
+        printf("[ISA] Self-test: allocation failed\n");
+        free(input);
+        free(expected);
+        free(actual);
+        return 1;
+    }
+
+    // Small sizes exhaustively, then a sweep around powers of 2 up to max_n
+    int sizes[128];
+    int num_sizes = 0;
+    for (int n = 1; n <= 40 && n <= max_n; n++) sizes[num_sizes++] = n;
+    for (int p = 64; p <= max_n && num_sizes + 3 <= 128; p *= 2) {
+        sizes[num_sizes++] = p - 1;
+        sizes[num_sizes++] = p;
+        if (p + 1 <= max_n) sizes[num_sizes++] = p + 1;
+    }
+
+    unsigned int seed = 12345;
+    for (int s = 0; s < num_sizes; s++) {
+        int n = sizes[s];
+        for (int i = 0; i < n; i++) {
+            seed = seed * 1103515245u + 12345u;
+            // Mix in negative keys so signed min/max are exercised
+            input[i] = (int)(seed >> 8) % 2001 - 1000;
+        }
+        memcpy(expected, input, n * sizeof(int));
+        run_network(&scalar_kernels, expected, n, 1);
+        for (int i = 1; i < n; i++) {
+            if (expected[i - 1] > expected[i]) {
+                printf("[ISA] Self-test: scalar network unsorted at n=%d\n", n);
+                failures++;
+                break;
+            }
+        }
+
+        for (int kset = 0; kset < NUM_KERNEL_SETS; kset++) {
+            const bitonic_kernels_t *kernels = all_kernels[kset];
+            if (kernels != &scalar_kernels && !cpu_supports(kernels)) continue;
+            for (int threads = 1; threads <= 3; threads += 2) {
+                memcpy(actual, input, n * sizeof(int));
+                run_network(kernels, actual, n, threads);
+                if (memcmp(actual, expected, n * sizeof(int)) != 0) {
+                    printf("[ISA] Self-test: %s differs from scalar at n=%d (%d threads)\n",
+                           kernels->name, n, threads);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    for (int kset = 0; kset < NUM_KERNEL_SETS; kset++) {
+        const bitonic_kernels_t *kernels = all_kernels[kset];
+        int supported = (kernels == &scalar_kernels || cpu_supports(kernels));
+        printf("[ISA] %-7s %s\n", kernels->name, supported ? "supported, checked" : "not supported");
+    }
+    printf("[ISA] Self-test over %d sizes: %s\n", num_sizes, failures == 0 ? "PASSED" : "FAILED");
+
+    free(input);
+    free(expected);
+    free(actual);
+    return failures == 0 ? 0 : 1;
+}
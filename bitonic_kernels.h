@@ -0,0 +1,40 @@
+#ifndef BITONIC_KERNELS_H
+#define BITONIC_KERNELS_H
+
+// Compare-exchange kernels for the iterative bitonic network.
+//
+// Every kernel moves the minimum of a pair to the lower index (the network
+// uses the mirrored first stage per merge, so all pairs sort ascending).
+// A kernel set is chosen once at startup from the CPU's ISA support; the
+// scalar set is always available as a bit-for-bit reference.
+
+typedef struct {
+    const char *name;
+    // Lanes per vector; stages with 2*j <= width run fully in registers
+    int width;
+    // lo[t] <-> hi[t] for t < len (large-stride stage)
+    void (*span)(int *lo, int *hi, long len);
+    // lo[t] <-> hi_end[-t] for t < len (mirrored first stage of a merge)
+    void (*span_mirror)(int *lo, int *hi_end, long len);
+    // Whole stage (k, j) inside each of `chunks` aligned chunks of `width`
+    // elements starting at arr; NULL when the set has no shuffle kernel
+    void (*chunk_stage)(int *arr, long chunks, int k, int j);
+} bitonic_kernels_t;
+
+// Kernel set by name ("auto", "scalar", "sse4.1", "avx2", "avx512"), or
+// NULL if the name is unknown or the CPU/OS lacks support for it
+const bitonic_kernels_t *bitonic_select_kernels(const char *name);
+
+// Number of live compare-exchange pairs of a stage with distance j over n
+// elements (pairs reaching past n are skipped)
+long bitonic_stage_pairs(int n, int j);
+
+// Run this thread's share of stage (k, j) over arr[0..n)
+void bitonic_stage(const bitonic_kernels_t *kernels, int *arr, int n, int k, int j,
+                   int thread_id, int num_threads);
+
+// Sort random arrays with every supported kernel set and compare the
+// output byte-for-byte against the scalar set. Returns 0 if all match.
+int bitonic_kernels_selftest(int max_n);
+
+#endif
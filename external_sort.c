@@ -0,0 +1,501 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "external_sort.h"
+
+#define MERGE_BLOCK_KEYS 65536      // 256 KB per merge buffer when memory allows
+#define MAX_FAN_IN 64
+#define MIN_MEM_LIMIT (64 * 1024)
+
+// One pread or pwrite for the I/O thread; offset and count are in keys
+typedef struct io_request {
+    int fd;
+    int write;
+    int *buf;
+    long count;
+    long long offset;
+    int done;
+    int error;
+    struct io_request *next;
+} io_request_t;
+
+// A sorted run being merged: reads alternate between two buffers
+typedef struct {
+    int *buf[2];
+    io_request_t req[2];
+    int cur;
+    long pos;
+    long len;
+    long long next;          // Next key to request
+    long long end;           // End of the run
+} merge_input_t;
+
+typedef struct {
+    int *buf[2];
+    io_request_t req[2];
+    int cur;
+    long len;
+    int fd;
+    long long offset;
+} merge_output_t;
+
+// Background I/O thread and its FIFO queue. Requests run in submission
+// order, so a read into a buffer queued after a write from it is safe.
+static pthread_t io_thread;
+static pthread_mutex_t io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t io_submitted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t io_completed = PTHREAD_COND_INITIALIZER;
+static io_request_t *io_head = NULL;
+static io_request_t *io_tail = NULL;
+static int io_stop = 0;
+static long long io_bytes_read = 0;
+static long long io_bytes_written = 0;
+static double io_wait_seconds = 0;   // Caller time blocked in io_wait
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+size_t external_sort_parse_size(const char *text) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text) return 0;
+    switch (*end) {
+    case 'k': case 'K': value <<= 10; end++; break;
+    case 'm': case 'M': value <<= 20; end++; break;
+    case 'g': case 'G': value <<= 30; end++; break;
+    default: break;
+    }
+    return *end == '\0' ? (size_t)value : 0;
+}
+
+static int transfer(const io_request_t *req) {
+    char *data = (char *)req->buf;
+    size_t left = req->count * sizeof(int);
+    off_t offset = req->offset * (off_t)sizeof(int);
+    while (left > 0) {
+        ssize_t moved = req->write ? pwrite(req->fd, data, left, offset)
+                                   : pread(req->fd, data, left, offset);
+        if (moved < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        if (moved == 0) return EIO;   // File shorter than expected
+        data += moved;
+        left -= moved;
+        offset += moved;
+    }
+    return 0;
+}
+
+static void *io_thread_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&io_mutex);
+    for (;;) {
+        while (!io_head && !io_stop) {
+            pthread_cond_wait(&io_submitted, &io_mutex);
+        }
+        // Stop only once the queue is drained
+        if (!io_head) break;
+        io_request_t *req = io_head;
+        io_head = req->next;
+        if (!io_head) io_tail = NULL;
+        pthread_mutex_unlock(&io_mutex);
+
+        int error = transfer(req);
+
+        pthread_mutex_lock(&io_mutex);
+        req->error = error;
+        req->done = 1;
+        if (req->write) io_bytes_written += req->count * sizeof(int);
+        else io_bytes_read += req->count * sizeof(int);
+        pthread_cond_broadcast(&io_completed);
+    }
+    pthread_mutex_unlock(&io_mutex);
+    return NULL;
+}
+
+static void io_submit(io_request_t *req, int fd, int write, int *buf, long count, long long offset) {
+    req->fd = fd;
+    req->write = write;
+    req->buf = buf;
+    req->count = count;
+    req->offset = offset;
+    req->done = 0;
+    req->error = 0;
+    req->next = NULL;
+    pthread_mutex_lock(&io_mutex);
+    if (io_tail) io_tail->next = req;
+    else io_head = req;
+    io_tail = req;
+    pthread_cond_signal(&io_submitted);
+    pthread_mutex_unlock(&io_mutex);
+}
+
+// Returns 0, or -1 with errno set if the transfer failed
+static int io_wait(io_request_t *req) {
+    double start = now_seconds();
+    pthread_mutex_lock(&io_mutex);
+    while (!req->done) {
+        pthread_cond_wait(&io_completed, &io_mutex);
+    }
+    pthread_mutex_unlock(&io_mutex);
+    io_wait_seconds += now_seconds() - start;
+    if (req->error) {
+        errno = req->error;
+        return -1;
+    }
+    return 0;
+}
+
+// An idle request: waiting on it returns at once
+static void io_idle(io_request_t *req) {
+    memset(req, 0, sizeof(*req));
+    req->done = 1;
+}
+
+// Finishes every queued request, then stops the thread
+static void io_shutdown(void) {
+    pthread_mutex_lock(&io_mutex);
+    io_stop = 1;
+    pthread_cond_signal(&io_submitted);
+    pthread_mutex_unlock(&io_mutex);
+    pthread_join(io_thread, NULL);
+    io_stop = 0;
+}
+
+static int make_temp(const char *dir) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/teamsort-XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        printf("[ERROR] Failed to create temp file in %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    unlink(path);
+    return fd;
+}
+
+static void checksum_add(const int *keys, long n, unsigned long long *checksum) {
+    for (long i = 0; i < n; i++) {
+        unsigned long long value = (unsigned long long)(long long)keys[i];
+        checksum[0] += value;
+        checksum[1] += value * value;
+    }
+}
+
+// Queue the run's next block into slot (nothing left: an empty, done slot)
+static void input_request(merge_input_t *in, int fd, int slot, long block) {
+    long count = in->end - in->next < block ? (long)(in->end - in->next) : block;
+    if (count == 0) {
+        io_idle(&in->req[slot]);
+        return;
+    }
+    io_submit(&in->req[slot], fd, 0, in->buf[slot], count, in->next);
+    in->next += count;
+}
+
+// Step to the run's next key; at the end of a buffer switch to the other
+// one and refill the finished one. *key is LLONG_MAX once the run is done.
+static int input_advance(merge_input_t *in, int fd, long block, long long *key) {
+    if (++in->pos < in->len) {
+        *key = in->buf[in->cur][in->pos];
+        return 0;
+    }
+    int used = in->cur;
+    in->cur ^= 1;
+    if (io_wait(&in->req[in->cur]) != 0) return -1;
+    in->len = in->req[in->cur].count;
+    in->pos = 0;
+    input_request(in, fd, used, block);
+    *key = in->len > 0 ? in->buf[in->cur][0] : LLONG_MAX;
+    return 0;
+}
+
+static int output_flush(merge_output_t *out) {
+    if (out->len == 0) return 0;
+    io_submit(&out->req[out->cur], out->fd, 1, out->buf[out->cur], out->len, out->offset);
+    out->offset += out->len;
+    out->len = 0;
+    out->cur ^= 1;
+    // The other buffer's previous write has to finish before it is refilled
+    return io_wait(&out->req[out->cur]);
+}
+
+// Loser tree over k inputs: tree[1..k-1] hold the loser of each match,
+// tree[0] the overall winner. Replay from leaf s after its key changed.
+static void tree_adjust(int *tree, const long long *keys, int k, int s) {
+    for (int t = (s + k) / 2; t > 0; t /= 2) {
+        int other = tree[t];
+        if (keys[other] < keys[s] || (keys[other] == keys[s] && other < s)) {
+            tree[t] = s;
+            s = other;
+        }
+    }
+    tree[0] = s;
+}
+
+// Merge k consecutive runs of src into one run of out. The final pass
+// also checks the order and the checksum of what it writes.
+static int merge_group(merge_input_t *inputs, int k, const long long *run_start, int src_fd,
+                       merge_output_t *out, long block, int verify, int *sorted,
+                       unsigned long long *checksum) {
+    long long keys[MAX_FAN_IN + 1];
+    int tree[MAX_FAN_IN];
+
+    for (int i = 0; i < k; i++) {
+        merge_input_t *in = &inputs[i];
+        in->next = run_start[i];
+        in->end = run_start[i + 1];
+        in->cur = 1;
+        in->pos = -1;
+        in->len = 0;
+        io_idle(&in->req[1]);
+        input_request(in, src_fd, 0, block);
+    }
+    for (int i = 0; i < k; i++) {
+        if (input_advance(&inputs[i], src_fd, block, &keys[i]) != 0) return -1;
+    }
+
+    // Index k is a virtual input with the smallest possible key; it loses
+    // its way out of the tree as the real inputs are played in
+    keys[k] = LLONG_MIN;
+    for (int t = 0; t < k; t++) tree[t] = k;
+    for (int i = k - 1; i >= 0; i--) tree_adjust(tree, keys, k, i);
+
+    long long previous = LLONG_MIN;
+    while (keys[tree[0]] != LLONG_MAX) {
+        int winner = tree[0];
+        int key = (int)keys[winner];
+        if (verify) {
+            if (key < previous) *sorted = 0;
+            previous = key;
+            unsigned long long value = (unsigned long long)(long long)key;
+            checksum[0] += value;
+            checksum[1] += value * value;
+        }
+        out->buf[out->cur][out->len++] = key;
+        if (out->len == block && output_flush(out) != 0) return -1;
+        if (input_advance(&inputs[winner], src_fd, block, &keys[winner]) != 0) return -1;
+        tree_adjust(tree, keys, k, winner);
+    }
+    if (output_flush(out) != 0) return -1;
+    if (io_wait(&out->req[0]) != 0 || io_wait(&out->req[1]) != 0) return -1;
+    return 0;
+}
+
+int external_sort(const external_sort_config_t *config, sort_batch_fn sort_run,
+                  external_sort_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    int in_fd = -1, src_fd = -1, dest_fd = -1, io_started = 0, result = -1;
+    long long *run_start = NULL;
+    int *run_buf[2] = {NULL, NULL};
+    int *merge_memory = NULL;
+    merge_input_t *inputs = NULL;
+    io_request_t reads[2], writes[2];
+    io_idle(&reads[0]);
+    io_idle(&reads[1]);
+    io_idle(&writes[0]);
+    io_idle(&writes[1]);
+
+    in_fd = open(config->path, O_RDWR);
+    struct stat st;
+    if (in_fd < 0 || fstat(in_fd, &st) != 0) {
+        printf("[ERROR] Failed to open %s: %s\n", config->path, strerror(errno));
+        goto done;
+    }
+    if (st.st_size % sizeof(int) != 0) {
+        printf("[ERROR] %s is not a whole number of int32 keys\n", config->path);
+        goto done;
+    }
+    if (config->mem_limit < MIN_MEM_LIMIT) {
+        printf("[ERROR] Memory limit must be at least %d bytes\n", MIN_MEM_LIMIT);
+        goto done;
+    }
+    long long n = st.st_size / sizeof(int);
+    stats->keys = n;
+    stats->sorted = 1;
+    stats->keys_preserved = 1;
+    if (n == 0) {
+        result = 0;
+        goto done;
+    }
+
+    // Two run buffers plus the batch function's scratch share the limit
+    long long mem_keys = config->mem_limit / sizeof(int);
+    long long run_keys = mem_keys / (config->run_scratch ? 3 : 2);
+    if (run_keys > INT_MAX / 2) run_keys = INT_MAX / 2;
+    if (run_keys > n) run_keys = n;
+    int runs = (int)((n + run_keys - 1) / run_keys);
+
+    // The merge gets the run buffers' memory back (the scratch stays)
+    long long merge_keys = mem_keys - (config->run_scratch ? run_keys : 0);
+    long block = MERGE_BLOCK_KEYS;
+    long long fan_in = merge_keys / (2 * block) - 1;
+    if (fan_in > MAX_FAN_IN) fan_in = MAX_FAN_IN;
+    if (fan_in < 2) {
+        fan_in = 2;
+        block = (long)(merge_keys / 6);
+    }
+    stats->run_keys = (long)run_keys;
+    stats->runs = runs;
+    stats->fan_in = (int)fan_in;
+    stats->merge_block_keys = block;
+
+    run_start = malloc((runs + 1) * sizeof(long long));
+    run_buf[0] = malloc(run_keys * sizeof(int));
+    run_buf[1] = malloc(run_keys * sizeof(int));
+    if (!run_start || !run_buf[0] || !run_buf[1]) {
+        printf("[ERROR] Failed to allocate run buffers: %s\n", strerror(errno));
+        goto done;
+    }
+    for (int r = 0; r <= runs; r++) {
+        run_start[r] = r < runs ? (long long)r * run_keys : n;
+    }
+
+    io_bytes_read = 0;
+    io_bytes_written = 0;
+    io_wait_seconds = 0;
+    if (pthread_create(&io_thread, NULL, io_thread_main, NULL) != 0) {
+        printf("[ERROR] Failed to start I/O thread\n");
+        goto done;
+    }
+    io_started = 1;
+
+    printf("[EXTERNAL] %lld keys in %d runs of up to %lld keys, merge fan-in %lld, %ld-key merge buffers\n",
+           n, runs, run_keys, fan_in, block);
+
+    // Run formation. A single run goes straight back to the input file.
+    double phase_start = now_seconds();
+    dest_fd = runs == 1 ? in_fd : make_temp(config->temp_dir);
+    if (dest_fd < 0) goto done;
+    unsigned long long input_checksum[2] = {0, 0}, output_checksum[2] = {0, 0};
+    io_submit(&reads[0], in_fd, 0, run_buf[0], (long)(run_start[1] - run_start[0]), 0);
+    for (int r = 0; r < runs; r++) {
+        int b = r & 1;
+        long len = (long)(run_start[r + 1] - run_start[r]);
+        if (io_wait(&reads[b]) != 0) {
+            printf("[ERROR] Failed to read run %d: %s\n", r, strerror(errno));
+            goto done;
+        }
+        // Queued behind the other buffer's pending write, so it cannot
+        // overwrite keys that have not reached the disk
+        if (r + 1 < runs) {
+            io_submit(&reads[b ^ 1], in_fd, 0, run_buf[b ^ 1],
+                      (long)(run_start[r + 2] - run_start[r + 1]), run_start[r + 1]);
+        }
+        checksum_add(run_buf[b], len, input_checksum);
+
+        double sort_start = now_seconds();
+        sort_job_t job = {run_buf[b], (int)len, 0, 0, 0};
+        sort_run(&job, 1);
+        stats->sort_seconds += now_seconds() - sort_start;
+
+        if (runs == 1) {
+            for (long i = 1; i < len; i++) {
+                if (run_buf[b][i - 1] > run_buf[b][i]) stats->sorted = 0;
+            }
+            checksum_add(run_buf[b], len, output_checksum);
+        }
+        io_submit(&writes[b], dest_fd, 1, run_buf[b], len, run_start[r]);
+        printf("[EXTERNAL] Run %d/%d: %ld keys sorted and spilled\n", r + 1, runs, len);
+    }
+    if (io_wait(&writes[0]) != 0 || io_wait(&writes[1]) != 0) {
+        printf("[ERROR] Failed to write run: %s\n", strerror(errno));
+        goto done;
+    }
+    stats->run_seconds = now_seconds() - phase_start;
+    stats->run_io_wait_seconds = io_wait_seconds;
+    free(run_buf[0]);
+    free(run_buf[1]);
+    run_buf[0] = run_buf[1] = NULL;
+
+    // Merge passes; each group of fan_in runs keeps its key range in the
+    // next file, so the run boundaries only thin out
+    phase_start = now_seconds();
+    io_wait_seconds = 0;
+    src_fd = dest_fd;
+    dest_fd = -1;
+    if (runs > 1) {
+        inputs = calloc(fan_in, sizeof(merge_input_t));
+        merge_memory = malloc((2 * fan_in + 2) * block * sizeof(int));
+        if (!inputs || !merge_memory) {
+            printf("[ERROR] Failed to allocate merge buffers: %s\n", strerror(errno));
+            goto done;
+        }
+        for (int i = 0; i < fan_in; i++) {
+            inputs[i].buf[0] = merge_memory + (2 * i) * block;
+            inputs[i].buf[1] = merge_memory + (2 * i + 1) * block;
+        }
+    }
+    merge_output_t out;
+    out.buf[0] = merge_memory ? merge_memory + (2 * fan_in) * block : NULL;
+    out.buf[1] = merge_memory ? merge_memory + (2 * fan_in + 1) * block : NULL;
+    while (runs > 1) {
+        double pass_start = now_seconds();
+        int groups = (int)((runs + fan_in - 1) / fan_in);
+        int last_pass = groups == 1;
+        dest_fd = last_pass ? in_fd : make_temp(config->temp_dir);
+        if (dest_fd < 0) goto done;
+
+        out.fd = dest_fd;
+        out.cur = 0;
+        out.len = 0;
+        io_idle(&out.req[0]);
+        io_idle(&out.req[1]);
+        int next_runs = 0;
+        for (int first = 0; first < runs; first += (int)fan_in) {
+            int k = runs - first < fan_in ? runs - first : (int)fan_in;
+            out.offset = run_start[first];
+            if (merge_group(inputs, k, run_start + first, src_fd, &out, block,
+                            last_pass, &stats->sorted, output_checksum) != 0) {
+                printf("[ERROR] Merge pass %d failed: %s\n", stats->merge_passes + 1, strerror(errno));
+                goto done;
+            }
+            run_start[next_runs++] = run_start[first];
+        }
+        run_start[next_runs] = n;
+
+        stats->merge_passes++;
+        printf("[EXTERNAL] Merge pass %d: %d runs into %d in %.6f seconds\n",
+               stats->merge_passes, runs, next_runs, now_seconds() - pass_start);
+        close(src_fd);
+        src_fd = last_pass ? -1 : dest_fd;
+        dest_fd = -1;
+        runs = next_runs;
+    }
+    if (fdatasync(in_fd) != 0) {
+        printf("[ERROR] Failed to flush %s: %s\n", config->path, strerror(errno));
+        goto done;
+    }
+    stats->merge_seconds = now_seconds() - phase_start;
+    stats->merge_io_wait_seconds = io_wait_seconds;
+    stats->keys_preserved = input_checksum[0] == output_checksum[0] &&
+                            input_checksum[1] == output_checksum[1];
+    result = 0;
+
+done:
+    if (io_started) {
+        io_shutdown();
+        stats->bytes_read = io_bytes_read;
+        stats->bytes_written = io_bytes_written;
+    }
+    if (dest_fd >= 0 && dest_fd != in_fd) close(dest_fd);
+    if (src_fd >= 0 && src_fd != in_fd) close(src_fd);
+    if (in_fd >= 0) close(in_fd);
+    free(run_start);
+    free(run_buf[0]);
+    free(run_buf[1]);
+    free(inputs);
+    free(merge_memory);
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <stddef.h>
+#include "sort_service.h"
+
+// External merge sort of binary int32 files larger than memory.
+//
+// Run formation: the file is read in runs as large as the memory limit
+// allows, each run is sorted by the caller's batch function (the warm
+// thread pool) and spilled to a temp file. Two run buffers alternate: while
+// the pool sorts one, a background I/O thread writes the previous run out
+// and reads the next one in.
+//
+// Merge: passes of k-way loser-tree merges, each input and the output
+// double-buffered through the same I/O thread, until one run is left. The
+// last pass writes over the input file, so the file ends up sorted in place.
+// Temp files are created in temp_dir and unlinked at once.
+//
+// The I/O thread is a plain pthread doing pread/pwrite from a FIFO queue
+// (no io_uring dependency).
+
+typedef struct {
+    const char *path;        // Input file, replaced by the sorted keys
+    const char *temp_dir;
+    size_t mem_limit;        // Bytes for run, scratch and merge buffers
+    int run_scratch;         // Batch function needs scratch as large as a run
+} external_sort_config_t;
+
+typedef struct {
+    long long keys;
+    long run_keys;           // Keys per run
+    int runs;                // Runs formed
+    int fan_in;              // Maximum merge fan-in
+    long merge_block_keys;   // Keys per merge buffer
+    int merge_passes;
+    double run_seconds;      // Run formation, wall clock
+    double sort_seconds;     // Time inside the batch function
+    double run_io_wait_seconds;
+    double merge_seconds;
+    double merge_io_wait_seconds;
+    long long bytes_read;
+    long long bytes_written;
+    int sorted;              // Output checked in order
+    int keys_preserved;      // Output checksum matches the input
+} external_sort_stats_t;
+
+// Parse a size such as "512M", "64K" or "2G" (bytes without a suffix).
+// Returns 0 if the text is not a size.
+size_t external_sort_parse_size(const char *text);
+
+// Returns 0 on success, -1 after printing an error
+int external_sort(const external_sort_config_t *config, sort_batch_fn sort_run,
+                  external_sort_stats_t *stats);
+
+#endif
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include "input_gen.h"
+
+#define FEW_UNIQUE_KEYS 16
+#define ZIPF_EXPONENT 1.1
+
+static const char *dist_names[] = {
+    "uniform", "sorted", "reversed", "few-unique", "zipf", "organ-pipe"
+};
+
+int input_dist_parse(const char *name) {
+    for (int dist = 0; dist < (int)(sizeof(dist_names) / sizeof(dist_names[0])); dist++) {
+        if (strcmp(name, dist_names[dist]) == 0) return dist;
+    }
+    return -1;
+}
+
+const char *input_dist_name(int dist) {
+    return dist_names[dist];
+}
+
+// Philox4x32-10 (Salmon et al., SC'11): ten rounds of two 32x32->64
+// multiplies with a Weyl-sequence key schedule
+static void philox4x32(unsigned long long counter, unsigned long long seed, uint32_t out[4]) {
+    uint32_t c0 = (uint32_t)counter, c1 = (uint32_t)(counter >> 32), c2 = 0, c3 = 0;
+    uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+int input_gen_init(input_gen_t *gen, int dist, unsigned long long seed, long n, int key_range) {
+    gen->dist = dist;
+    gen->seed = seed;
+    gen->n = n;
+    gen->key_range = key_range;
+    gen->zipf_cdf = NULL;
+    if (dist != DIST_ZIPF) return 0;
+
+    gen->zipf_cdf = malloc(key_range * sizeof(double));
+    if (!gen->zipf_cdf) {
+        errno = ENOMEM;
+        return -1;
+    }
+    double total = 0;
+    for (int k = 0; k < key_range; k++) {
+        total += 1.0 / pow(k + 1, ZIPF_EXPONENT);
+        gen->zipf_cdf[k] = total;
+    }
+    for (int k = 0; k < key_range; k++) {
+        gen->zipf_cdf[k] /= total;
+    }
+    gen->zipf_cdf[key_range - 1] = 1.0;
+    return 0;
+}
+
+void input_gen_destroy(input_gen_t *gen) {
+    free(gen->zipf_cdf);
+    gen->zipf_cdf = NULL;
+}
+
+static int zipf_key(const input_gen_t *gen, uint32_t random) {
+    double u = (random + 0.5) / 4294967296.0;
+    int low = 0, high = gen->key_range - 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (gen->zipf_cdf[mid] < u) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+void input_gen_fill(const input_gen_t *gen, int *out, long first, long last) {
+    long n = gen->n;
+    long range = gen->key_range;
+    uint32_t block[4];
+    long block_index = -1;
+
+    for (long i = first; i < last; i++) {
+        int key;
+        switch (gen->dist) {
+        case DIST_SORTED:
+            key = (int)(i * range / n);
+            break;
+        case DIST_REVERSED:
+            key = (int)((n - 1 - i) * range / n);
+            break;
+        case DIST_ORGAN_PIPE: {
+            long distance = (i < n - 1 - i) ? i : n - 1 - i;
+            key = (int)(2 * distance * range / n);
+            break;
+        }
+        default: {
+            if (i / 4 != block_index) {
+                block_index = i / 4;
+                philox4x32((unsigned long long)block_index, gen->seed, block);
+            }
+            uint32_t random = block[i % 4];
+            if (gen->dist == DIST_ZIPF) {
+                key = zipf_key(gen, random);
+            } else if (gen->dist == DIST_FEW_UNIQUE) {
+                key = (int)(((uint64_t)random * FEW_UNIQUE_KEYS) >> 32) * (int)(range / FEW_UNIQUE_KEYS);
+            } else {
+                key = (int)(((uint64_t)random * range) >> 32);
+            }
+            break;
+        }
+        }
+        out[i - first] = key;
+    }
+}
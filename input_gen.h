@@ -0,0 +1,41 @@
+#ifndef INPUT_GEN_H
+#define INPUT_GEN_H
+
+// Reproducible parallel input generation.
+//
+// Key i depends only on (seed, distribution, n, i): random draws come from
+// Philox4x32-10, a counter-based generator, evaluated at counter i / 4.
+// Any thread can generate any slice independently, and the array is the
+// same for every thread count and slicing, so a run repeats exactly with
+// the same --seed.
+
+#define DIST_UNIFORM    0   // Uniform in [0, key_range)
+#define DIST_SORTED     1   // Non-decreasing ramp over [0, key_range)
+#define DIST_REVERSED   2   // Non-increasing ramp
+#define DIST_FEW_UNIQUE 3   // 16 distinct keys spread over the range
+#define DIST_ZIPF       4   // Key k with probability ~ 1 / (k + 1)^1.1
+#define DIST_ORGAN_PIPE 5   // Ramp up to the middle, then back down
+
+typedef struct {
+    int dist;
+    unsigned long long seed;
+    long n;
+    int key_range;
+    double *zipf_cdf;   // [key_range], Zipf only
+} input_gen_t;
+
+// Returns the distribution for "uniform", "sorted", "reversed",
+// "few-unique", "zipf" or "organ-pipe", or -1
+int input_dist_parse(const char *name);
+
+const char *input_dist_name(int dist);
+
+// Returns 0 on success, -1 with errno set on failure
+int input_gen_init(input_gen_t *gen, int dist, unsigned long long seed, long n, int key_range);
+
+// Generate keys first..last-1 of the array into out[0..last-first)
+void input_gen_fill(const input_gen_t *gen, int *out, long first, long last);
+
+void input_gen_destroy(input_gen_t *gen);
+
+#endif
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "mapped_file.h"
+
+#define PAGE_KEYS (4096 / sizeof(int))
+
+int mapped_file_open(mapped_file_t *file, const char *path, long max_count) {
+    file->fd = -1;
+    file->keys = NULL;
+    file->count = 0;
+    file->length = 0;
+    file->hugepages = 0;
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size <= 0 || st.st_size % sizeof(int) != 0 ||
+        st.st_size / (long)sizeof(int) > max_count) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *keys = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (keys == MAP_FAILED) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    // Hints only: a kernel or file system without them still sorts correctly
+    madvise(keys, st.st_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    file->hugepages = madvise(keys, st.st_size, MADV_HUGEPAGE) == 0;
+#endif
+
+    file->fd = fd;
+    file->keys = keys;
+    file->count = st.st_size / sizeof(int);
+    file->length = st.st_size;
+    return 0;
+}
+
+void mapped_file_prefault(const mapped_file_t *file, long first, long last) {
+    // Store the key back as well: a read fault on a shared mapping leaves
+    // the page write-protected, and the sort's first write would fault again
+    volatile int *keys = file->keys;
+    for (long i = first; i < last; i += PAGE_KEYS) {
+        keys[i] = keys[i];
+    }
+}
+
+int mapped_file_sync(mapped_file_t *file) {
+    return msync(file->keys, file->length, MS_SYNC);
+}
+
+void mapped_file_close(mapped_file_t *file) {
+    if (file->keys) munmap(file->keys, file->length);
+    if (file->fd >= 0) close(file->fd);
+    file->keys = NULL;
+    file->fd = -1;
+}
+
+void mapped_file_fault_counts(long *minor, long *major) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    *minor = usage.ru_minflt;
+    *major = usage.ru_majflt;
+}
@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// In-place sorting of binary int32 files.
+//
+// The file (host byte order, no header) is mapped shared and read/write, so
+// the sort threads work on the page cache directly and the sorted keys go
+// back to the file with msync. The mapping is advised MADV_SEQUENTIAL
+// (aggressive readahead) and MADV_HUGEPAGE (honoured only where the kernel
+// supports huge pages for the file system, e.g. tmpfs; otherwise ignored).
+
+typedef struct {
+    int fd;
+    int *keys;
+    long count;
+    size_t length;
+    int hugepages;      // MADV_HUGEPAGE accepted
+} mapped_file_t;
+
+// Map path. Returns 0 on success, -1 with errno set on failure (EINVAL if
+// the file is empty, not a whole number of keys or over max_count keys).
+int mapped_file_open(mapped_file_t *file, const char *path, long max_count);
+
+// Touch keys first..last-1 once per page (read and write) so the page
+// faults and readahead happen here rather than inside the timed sort
+void mapped_file_prefault(const mapped_file_t *file, long first, long last);
+
+// Write dirty pages back and wait. Returns 0 or -1 with errno set.
+int mapped_file_sync(mapped_file_t *file);
+
+void mapped_file_close(mapped_file_t *file);
+
+// Process-wide minor and major page faults so far (getrusage)
+void mapped_file_fault_counts(long *minor, long *major);
+
+#endif
@@ -0,0 +1,176 @@
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counters.h"
+
+#define CACHE_EVENT(cache, op, result) \
+    ((cache) | ((op) << 8) | ((result) << 16))
+
+static const struct {
+    unsigned int type;
+    unsigned long long config;
+} hardware_events[PERF_COUNTERS_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},     // Last-level cache on most CPUs
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                     PERF_COUNT_HW_CACHE_RESULT_MISS)},
+};
+
+static const char *event_names[2][PERF_COUNTERS_EVENTS] = {
+    {"cpu ns", "minor faults", "major faults", "vol switches", "invol switches"},
+    {"cycles", "instructions", "LLC misses", "branch misses", "dTLB misses"},
+};
+
+static long long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Current totals of the calling thread, by event. Returns 0, or -1 if the
+// group could not be read.
+static int read_counters(perf_counters_t *pc, long long values[PERF_COUNTERS_EVENTS],
+                         long long *enabled_ns, long long *running_ns) {
+    if (pc->counts.mode == PERF_COUNTERS_SOFTWARE) {
+        struct timespec cpu;
+        struct rusage usage;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+        getrusage(RUSAGE_THREAD, &usage);
+        values[0] = cpu.tv_sec * 1000000000LL + cpu.tv_nsec;
+        values[1] = usage.ru_minflt;
+        values[2] = usage.ru_majflt;
+        values[3] = usage.ru_nvcsw;
+        values[4] = usage.ru_nivcsw;
+        *enabled_ns = *running_ns = 0;
+        return 0;
+    }
+
+    // PERF_FORMAT_GROUP: nr, time_enabled, time_running, one value per event
+    unsigned long long buffer[3 + PERF_COUNTERS_EVENTS];
+    ssize_t expected = (3 + pc->num_events) * sizeof(buffer[0]);
+    if (read(pc->group_fd, buffer, sizeof(buffer)) != expected) return -1;
+    memset(values, 0, PERF_COUNTERS_EVENTS * sizeof(values[0]));
+    for (int i = 0; i < pc->num_events; i++) {
+        values[pc->event_of[i]] = (long long)buffer[3 + i];
+    }
+    *enabled_ns = (long long)buffer[1];
+    *running_ns = (long long)buffer[2];
+    return 0;
+}
+
+void perf_counts_init(perf_counts_t *counts, int mode) {
+    memset(counts, 0, sizeof(*counts));
+    counts->mode = mode;
+    counts->available = (1u << PERF_COUNTERS_EVENTS) - 1;
+}
+
+void perf_counters_open(perf_counters_t *pc, int software_only) {
+    perf_counts_init(&pc->counts, PERF_COUNTERS_SOFTWARE);
+    pc->group_fd = -1;
+    pc->num_events = 0;
+    pc->phase = -1;
+
+    if (!software_only) {
+        unsigned int available = 0;
+        for (int e = 0; e < PERF_COUNTERS_EVENTS; e++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = hardware_events[e].type;
+            attr.config = hardware_events[e].config;
+            attr.disabled = pc->group_fd < 0;       // The leader starts the group
+            attr.exclude_kernel = 1;                // Allowed at perf_event_paranoid 2
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, pc->group_fd,
+                                  PERF_FLAG_FD_CLOEXEC);
+            if (fd < 0) continue;
+            if (pc->group_fd < 0) pc->group_fd = fd;
+            pc->fds[pc->num_events] = fd;
+            pc->event_of[pc->num_events++] = e;
+            available |= 1u << e;
+        }
+        if (pc->group_fd >= 0) {
+            pc->counts.mode = PERF_COUNTERS_HARDWARE;
+            pc->counts.available = available;
+            ioctl(pc->group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(pc->group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+    pc->counts.threads = 1;
+
+    if (read_counters(pc, pc->last, &pc->last_enabled_ns, &pc->last_running_ns) != 0) {
+        memset(pc->last, 0, sizeof(pc->last));
+        pc->last_enabled_ns = pc->last_running_ns = 0;
+    }
+    pc->last_wall_ns = now_ns();
+}
+
+void perf_counters_phase(perf_counters_t *pc, int phase) {
+    if (phase == pc->phase) return;
+    long long values[PERF_COUNTERS_EVENTS], enabled_ns, running_ns;
+    if (read_counters(pc, values, &enabled_ns, &running_ns) != 0) {
+        // Keep the previous totals: the lost interval counts as zero
+        memcpy(values, pc->last, sizeof(values));
+        enabled_ns = pc->last_enabled_ns;
+        running_ns = pc->last_running_ns;
+    }
+    long long wall = now_ns();
+
+    if (pc->phase >= 0) {
+        perf_phase_counts_t *counts = &pc->counts.phases[pc->phase];
+        for (int e = 0; e < PERF_COUNTERS_EVENTS; e++) {
+            counts->values[e] += values[e] - pc->last[e];
+        }
+        counts->wall_ns += wall - pc->last_wall_ns;
+        pc->counts.enabled_ns += enabled_ns - pc->last_enabled_ns;
+        pc->counts.running_ns += running_ns - pc->last_running_ns;
+    }
+    if (phase >= 0 && phase < PERF_COUNTERS_MAX_PHASES) {
+        pc->counts.phases[phase].entries++;
+        pc->phase = phase;
+    } else {
+        pc->phase = -1;
+    }
+    memcpy(pc->last, values, sizeof(values));
+    pc->last_wall_ns = wall;
+    pc->last_enabled_ns = enabled_ns;
+    pc->last_running_ns = running_ns;
+}
+
+void perf_counters_close(perf_counters_t *pc) {
+    perf_counters_phase(pc, -1);
+    if (pc->group_fd >= 0) {
+        ioctl(pc->group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        for (int i = 0; i < pc->num_events; i++) {
+            close(pc->fds[i]);
+        }
+        pc->group_fd = -1;
+        pc->num_events = 0;
+    }
+}
+
+void perf_counts_merge(perf_counts_t *dst, const perf_counts_t *src) {
+    dst->threads += src->threads;
+    dst->available &= src->available;
+    dst->enabled_ns += src->enabled_ns;
+    dst->running_ns += src->running_ns;
+    for (int p = 0; p < PERF_COUNTERS_MAX_PHASES; p++) {
+        for (int e = 0; e < PERF_COUNTERS_EVENTS; e++) {
+            dst->phases[p].values[e] += src->phases[p].values[e];
+        }
+        dst->phases[p].wall_ns += src->phases[p].wall_ns;
+        dst->phases[p].entries += src->phases[p].entries;
+    }
+}
+
+const char *perf_counters_event_name(int mode, int event) {
+    return event_names[mode][event];
+}
@@ -0,0 +1,77 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Per-thread performance counters, attributed to phases.
+//
+// Each thread opens its own counter group with perf_event_open (pid 0, any
+// CPU, so only the calling thread is counted) and reports phase changes
+// with perf_counters_phase: what was counted since the previous change goes
+// to the phase being left, at the cost of one read() of the group.
+//
+// Hardware mode counts cycles, instructions, last-level cache misses,
+// branch misses and dTLB read misses. Events the CPU or hypervisor does not
+// offer are left out of the group and print as n/a. When no hardware event
+// can be opened (perf_event_paranoid, containers, seccomp, or the file
+// descriptor limit with thousands of threads), the thread falls back to
+// software counters from the kernel's own accounting: thread CPU time,
+// minor and major page faults, voluntary and involuntary context switches.
+// Wall time per phase is kept in both modes.
+//
+// Counts are accumulated in the thread's perf_counters_t and merged into
+// per-team totals (perf_counts_t) when the thread is done.
+
+#define PERF_COUNTERS_EVENTS 5
+#define PERF_COUNTERS_MAX_PHASES 40
+
+#define PERF_COUNTERS_SOFTWARE 0
+#define PERF_COUNTERS_HARDWARE 1
+
+typedef struct {
+    long long values[PERF_COUNTERS_EVENTS];
+    long long wall_ns;
+    long long entries;                          // Times the phase was entered
+} perf_phase_counts_t;
+
+// Counts of one mode; threads in different modes are kept apart
+typedef struct {
+    int mode;
+    int threads;                // Threads merged in
+    unsigned int available;     // Bit e: event e was counted by every thread
+    long long enabled_ns;       // Hardware: group enabled and actually counting;
+    long long running_ns;       // less running than enabled means multiplexing
+    perf_phase_counts_t phases[PERF_COUNTERS_MAX_PHASES];
+} perf_counts_t;
+
+typedef struct {
+    int group_fd;                           // Leader, -1 in software mode
+    int num_events;
+    int fds[PERF_COUNTERS_EVENTS];          // By group position
+    int event_of[PERF_COUNTERS_EVENTS];     // Group position -> event
+    int phase;                              // Current phase, -1 for none
+    long long last[PERF_COUNTERS_EVENTS];
+    long long last_wall_ns;
+    long long last_enabled_ns;
+    long long last_running_ns;
+    perf_counts_t counts;       // counts.mode is the thread's mode
+} perf_counters_t;
+
+// Start counting on the calling thread in hardware mode if possible,
+// software mode otherwise (or always, with software_only). No phase is
+// current until the first perf_counters_phase.
+void perf_counters_open(perf_counters_t *pc, int software_only);
+
+// Switch the calling thread to phase (0 .. PERF_COUNTERS_MAX_PHASES-1)
+void perf_counters_phase(perf_counters_t *pc, int phase);
+
+// Close the current phase and the counters
+void perf_counters_close(perf_counters_t *pc);
+
+void perf_counts_init(perf_counts_t *counts, int mode);
+
+// Add src to dst, which must be of the same mode. Not thread-safe.
+void perf_counts_merge(perf_counts_t *dst, const perf_counts_t *src);
+
+// Name of event (column header) in mode
+const char *perf_counters_event_name(int mode, int event);
+
+#endif
@@ -8,25 +8,151 @@
 #include <sys/wait.h>
 #include <errno.h>
 #include <limits.h>
+#include <getopt.h>
+#include "teamsort.h"
+#include "bitonic_kernels.h"
+#include "sort_barrier.h"
+#include "sort_service.h"
+#include "team_placement.h"
+#include "input_gen.h"
+#include "mapped_file.h"
+#include "external_sort.h"
+#include "signal_log.h"
+#include "signal_dispatch.h"
+#include "signal_load.h"
+#include "perf_counters.h"
+#include "thread_trace.h"
+#include "thread_log.h"
 
 // Configuration constants
 #define NUM_TEAMS 4
 #define DEFAULT_ARRAY_SIZE 10000
 #define DEFAULT_THREADS_PER_TEAM 4
+#define KEY_RANGE 10000             // Generated keys are in [0, KEY_RANGE)
+#define SERVICE_MAX_BATCH 1024
+#define DEFAULT_MEM_LIMIT ((size_t)256 << 20)   // External sort buffers
 
 // Global state
 int *main_array;
 int array_size = DEFAULT_ARRAY_SIZE;
 int padded_array_size;
+int pad_to_power_of_2 = 0;
+int sort_algorithm = TEAMSORT_BITONIC;
 int threads_per_team = DEFAULT_THREADS_PER_TEAM;
 int completion_order[NUM_TEAMS] = {-1, -1, -1, -1};
 int completion_index = 0;
 pthread_mutex_t completion_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-// Bitonic sort synchronization
-pthread_barrier_t global_barrier;
+// The sort engines live in libteamsort. The team threads are the
+// context's workers: they run teamsort_worker, and main submits the array
+// (or the service and external batches) to them.
+teamsort_t *sorter = NULL;
+int barrier_kind = SORT_BARRIER_FUTEX;
+long barrier_spin_limit = -1;   // -1: pick from the thread count
+const char *kernel_set = "auto";
+
+// Array mode: the threads generate their blocks, then meet main here so
+// the timing covers the sort only. One extra participant, main.
+sort_barrier_t start_barrier;
+
+// Team placement. When teams are pinned, the blocks each thread generates
+// (first-touches) land on the node it runs on, instead of main
+// initializing everything from node 0.
+int placement_mode = PLACEMENT_NONE;
+team_placement_t placement;
+
+// Input generation: each sort thread generates its own block of main_array
+// before the start barrier. Keys depend only on the seed and the global
+// index, so a seed reproduces the same input for any thread count.
+input_gen_t input_gen;
+int input_dist = DIST_UNIFORM;
+unsigned long long input_seed;
+int input_seed_given = 0;
+long generate_ns_max = 0;   // Slowest thread's generation time
+
+// File mode: main_array is a shared mapping of the input file, sorted in
+// place and written back with msync. The threads' generation step becomes
+// a fault-in of their block, so page faults and readahead are timed apart
+// from the sort. Fault counts: [0] minor, [1] major.
+const char *input_file = NULL;
+mapped_file_t mapped_input;
+double file_map_seconds = 0;
+double file_sync_seconds = 0;
+long faults_start[2], faults_loaded[2], faults_sorted[2];
+
+// Service mode: the sort threads stay warm inside teamsort_worker and
+// main hands them each batch of jobs from the endpoint
+const char *service_endpoint = NULL;
 int sort_completed = 0;
 
+// External sort (--external with --file): the pool stays warm as in
+// service mode and each memory-sized run is handed to it as a one-job
+// batch; external_sort.c does the spilling, merging and I/O
+int external_mode = 0;
+size_t external_mem_limit = DEFAULT_MEM_LIMIT;
+const char *external_temp_dir = "/tmp";
+
+// Signal delivery. Handler mode (default): each team thread unblocks its
+// team's signals and the kernel interrupts one of them. Dispatch mode: the
+// team threads keep every signal blocked, a dispatcher thread reads them
+// from a signalfd and the team leaders take them from their mailboxes at
+// stage boundaries, so no stage is ever interrupted (signal_dispatch.c).
+// Both build on the routing table made from team_signals.
+int signal_dispatch_mode = 0;
+signal_routes_t signal_routes;
+
+// Latency and sequence gaps of tagged signals from signal_tester's load
+// mode, updated by the logger thread
+signal_load_t signal_load;
+
+// Signal load benchmark (--bench-signals): after the regular sort, the
+// same input is sorted again under internal signal traffic at each rate of
+// the sweep. A sender thread queues every team's team_signals in turn to
+// this process; the logger counts which team took each one.
+#define BENCH_MAX_RATES 32
+#define BENCH_TICKS_PER_SEC 10000   // Sender wakeups; faster rates send bursts
+double bench_rates[BENCH_MAX_RATES];
+int bench_num_rates = 0;
+int bench_repeats = 3;
+int *bench_input = NULL;            // Unsorted input, restored before each run
+long long team_signal_events[NUM_TEAMS];
+double bench_sender_rate;
+int bench_sender_stop;
+long long bench_sender_sent;
+
+// Performance counters (--perf): every sort thread counts its own phases,
+// the libteamsort ones through the context's phase hook plus input
+// generation and the start barrier; main counts the verification. A
+// thread's counts are merged into its team's totals when it exits, kept
+// apart by mode in case some threads had to fall back to software counters.
+#define PERF_PHASE_INPUT      TEAMSORT_PHASES
+#define PERF_PHASE_START_WAIT (TEAMSORT_PHASES + 1)
+#define PERF_PHASE_VERIFY     (TEAMSORT_PHASES + 2)
+#define PERF_OFF      0
+#define PERF_AUTO     1     // Hardware events, software fallback
+#define PERF_SOFTWARE 2
+int perf_mode = PERF_OFF;
+perf_counts_t perf_team_counts[NUM_TEAMS][2];
+perf_counts_t perf_main_counts[2];
+pthread_mutex_t perf_lock = PTHREAD_MUTEX_INITIALIZER;
+__thread perf_counters_t *perf_self = NULL;
+
+// Timeline trace (--trace=FILE): every sort thread and main record their
+// phases, signal handlers and thread start/exit into their own buffers,
+// written as Chrome trace JSON after the join. The team is the trace's
+// process, so each team gets one block of tracks.
+#define TRACE_DEFAULT_EVENTS 16384
+const char *trace_path = NULL;
+long trace_events = TRACE_DEFAULT_EVENTS;
+char merge_phase_names[32][16];
+__thread int trace_phase = -1;
+
+// Progress output (--log): per-thread lines are debug, main's progress and
+// the signal reports info. Lines go through per-thread buffers to a writer
+// thread; below debug they are held while the teams run and the sort is
+// timed, and written in one batch after it.
+int log_level = THREAD_LOG_INFO;
+
 // Team data structure
 typedef struct {
     int team_id;
@@ -51,29 +177,34 @@ int team_signals[NUM_TEAMS][3] = {
     {SIGABRT, SIGFPE, SIGHUP}       // Team 3
 };
 
-void signal_handler(int sig) {
-    pthread_t current_thread = pthread_self();
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    char timestamp[26];
-    strftime(timestamp, 26, "%Y-%m-%d %H:%M:%S", tm_info);
-    
-    int team_id = -1;
-    int thread_index = -1;
-    
-    // Find which team this thread belongs to
-    for (int i = 0; i < NUM_TEAMS && team_id == -1; i++) {
-        for (int j = 0; j < teams[i].num_threads; j++) {
-            if (pthread_equal(current_thread, teams[i].threads[j])) {
-                team_id = i;
-                thread_index = j;
-                break;
-            }
-        }
+// Runs on whichever sort thread the kernel interrupts: only records the
+// event in that thread's ring (see signal_log.c). Dispatch mode records
+// the same events from poll_team_signals instead.
+void signal_handler(int sig, siginfo_t *info, void *context) {
+    (void)context;
+    thread_trace_event(THREAD_TRACE_BEGIN, "signal handler", sig);
+    signal_log_record(sig, info->si_pid, info->si_code, (long long)(intptr_t)info->si_value.sival_ptr);
+    thread_trace_event(THREAD_TRACE_END, "signal handler", sig);
+}
+
+// Logger thread: format the events the handlers recorded
+void report_signal(const signal_event_t *event) {
+    char timestamp[32];
+    signal_log_timestamp(event->time_ns, timestamp, sizeof(timestamp));
+    int team_id = event->team;
+    int sig = event->sig;
+    if (team_id >= 0 && team_id < NUM_TEAMS) {
+        __atomic_add_fetch(&team_signal_events[team_id], 1, __ATOMIC_RELAXED);
     }
     
-    printf("[SIGNAL %s] Team %d, Thread %d caught signal %d (%s)\n", 
-           timestamp, team_id, thread_index, sig, strsignal(sig));
+    // Load generator traffic (signal_tester --rate/--count) is only
+    // summarized at exit
+    signal_load_add(&signal_load, sig, event->sender, event->code, event->value, event->time_ns);
+    if (event->code == SI_QUEUE) return;
+    
+    thread_log(THREAD_LOG_INFO, "[SIGNAL %s] Team %d, Thread %d %s signal %d (%s), %lld ns in handler\n", 
+               timestamp, team_id, event->thread,
+               signal_dispatch_mode ? "took mailbox" : "caught", sig, strsignal(sig), event->handler_ns);
     
     // Check if this signal should be handled by this team
     int should_handle = 0;
@@ -87,18 +218,27 @@ void signal_handler(int sig) {
     }
     
     if (should_handle) {
-        printf("[SIGNAL %s] ✓ Signal %d handled correctly by Team %d\n", timestamp, sig, team_id);
+        thread_log(THREAD_LOG_INFO, "[SIGNAL %s] ✓ Signal %d handled correctly by Team %d\n",
+                   timestamp, sig, team_id);
     } else {
-        printf("[SIGNAL %s] ⚠ Signal %d received by Team %d (not assigned)\n", timestamp, sig, team_id);
+        thread_log(THREAD_LOG_INFO, "[SIGNAL %s] ⚠ Signal %d received by Team %d (not assigned)\n",
+                   timestamp, sig, team_id);
     }
-    
-    fflush(stdout);
 }
 
 // Function declarations
-void bitonic_compare_and_swap(int *arr, int i, int j, int ascending);
-void bitonic_merge(int *arr, int start, int length, int ascending, int thread_id, int num_threads);
-void bitonic_sort_parallel(int *arr, int start, int length, int ascending, int thread_id, int num_threads);
+long long bitonic_padded_work(int n);
+void generate_block(int thread_id, int num_threads);
+void run_service_batch(sort_job_t *jobs, int num_jobs);
+int run_array_sort(void);
+void run_signal_bench(void);
+void *bench_sender(void *arg);
+int parse_bench_rates(const char *list);
+void report_signal(const signal_event_t *event);
+void poll_team_signals(void *arg, int thread_id);
+void record_phase(void *arg, int thread_id, int phase);
+const char *phase_name(int phase);
+void print_perf_summary(void);
 int next_power_of_2(int n);
 
 int next_power_of_2(int n) {
@@ -109,92 +249,123 @@ int next_power_of_2(int n) {
     return power;
 }
 
-void bitonic_compare_and_swap(int *arr, int i, int j, int ascending) {
-    if ((arr[i] > arr[j]) == ascending) {
-        int temp = arr[i];
-        arr[i] = arr[j];
-        arr[j] = temp;
+// Compare-exchange work of the classic network padded to a power of 2
+long long bitonic_padded_work(int n) {
+    long long padded = next_power_of_2(n);
+    long long stages = 0;
+    for (long long k = 2; k <= padded; k <<= 1) {
+        for (long long j = k >> 1; j > 0; j >>= 1) {
+            stages++;
+        }
     }
+    return stages * (padded / 2);
 }
 
-void bitonic_merge(int *arr, int start, int length, int ascending, int thread_id, int num_threads) {
-    if (length <= 1) return;
-    
-    int half = length / 2;
-    
-    // Calculate work distribution for this thread for compare-and-swap phase
-    int work_per_thread = (half + num_threads - 1) / num_threads;
-    int thread_start = thread_id * work_per_thread;
-    int thread_end = thread_start + work_per_thread;
-    if (thread_end > half) thread_end = half;
-    
-    // All threads participate in parallel compare-and-swap phase
-    for (int i = thread_start; i < thread_end; i++) {
-        bitonic_compare_and_swap(arr, start + i, start + i + half, ascending);
+// Service and external batches go to the warm pool as int32 jobs
+void run_service_batch(sort_job_t *jobs, int num_jobs) {
+    static teamsort_job_t batch[SERVICE_MAX_BATCH];
+    for (int i = 0; i < num_jobs; i++) {
+        batch[i].type = TEAMSORT_INT32;
+        batch[i].data = jobs[i].data;
+        batch[i].n = jobs[i].n;
+    }
+    if (teamsort_sort(sorter, batch, num_jobs) != 0) {
+        printf("[ERROR] Failed to sort batch: %s\n", strerror(errno));
+        exit(1);
     }
-    
-    // Synchronize all threads after compare-and-swap
-    pthread_barrier_wait(&global_barrier);
-    
-    // All threads recursively merge both halves
-    bitonic_merge(arr, start, half, ascending, thread_id, num_threads);
-    bitonic_merge(arr, start + half, half, ascending, thread_id, num_threads);
 }
 
-void bitonic_sort_parallel(int *arr, int start, int length, int ascending, int thread_id, int num_threads) {
-    if (length <= 1) return;
-    
-    int half = length / 2;
-    
-    // All threads work on both halves but in opposite directions
-    bitonic_sort_parallel(arr, start, half, 1, thread_id, num_threads);
-    bitonic_sort_parallel(arr, start + half, half, 0, thread_id, num_threads);
-    
-    // Synchronize before merge
-    pthread_barrier_wait(&global_barrier);
-    
-    // Merge the two bitonic sequences
-    bitonic_merge(arr, start, length, ascending, thread_id, num_threads);
-}
 void setup_team_signals(int team_id) {
     if (team_id < 0 || team_id >= NUM_TEAMS) {
         printf("[ERROR] Invalid team_id %d\n", team_id);
         return;
     }
     
-    sigset_t block_set;
-    sigemptyset(&block_set);
+    // Both sets come ready-made from the routing table
+    if (pthread_sigmask(SIG_BLOCK, &signal_routes.others[team_id], NULL) != 0 ||
+        pthread_sigmask(SIG_UNBLOCK, &signal_routes.own[team_id], NULL) != 0) {
+        printf("[ERROR] Team %d: Failed to set signal mask: %s\n", team_id, strerror(errno));
+    } else {
+        thread_log(THREAD_LOG_DEBUG, "[SETUP] Team %d: Blocked signals of other teams, unblocked %d, %d, %d\n",
+                   team_id, team_signals[team_id][0], team_signals[team_id][1], team_signals[team_id][2]);
+    }
+}
+
+// Stage hook of the sort context (dispatch mode): each team's thread 0
+// takes its team's messages and records them like the handler would
+void poll_team_signals(void *arg, int thread_id) {
+    (void)arg;
+    if (thread_id % threads_per_team != 0) return;
+    signal_message_t msg;
+    while (signal_dispatch_poll(thread_id / threads_per_team, &msg)) {
+        thread_trace_event(THREAD_TRACE_INSTANT, "signal taken", msg.sig);
+        signal_log_record(msg.sig, msg.sender, msg.code, msg.value);
+    }
+}
+
+const char *phase_name(int phase) {
+    switch (phase) {
+    case TEAMSORT_PHASE_IDLE: return "idle";
+    case TEAMSORT_PHASE_LOCAL: return "local sort";
+    case TEAMSORT_PHASE_RADIX: return "radix";
+    case TEAMSORT_PHASE_BARRIER: return "barrier";
+    case PERF_PHASE_INPUT: return "input";
+    case PERF_PHASE_START_WAIT: return "start wait";
+    case PERF_PHASE_VERIFY: return "verify";
+    default: return merge_phase_names[(phase - TEAMSORT_PHASE_MERGE) & 31];
+    }
+}
+
+// Phase hook of the sort context, also called around the steps outside
+// libteamsort: attributes counters and closes/opens the trace slice. -1
+// ends the current phase.
+void record_phase(void *arg, int thread_id, int phase) {
+    (void)arg;
+    (void)thread_id;
+    if (perf_self) {
+        perf_counters_phase(perf_self, phase);
+    }
+    if (trace_path && phase != trace_phase) {
+        if (trace_phase >= 0) {
+            thread_trace_event(THREAD_TRACE_END, phase_name(trace_phase), -1);
+        }
+        if (phase >= 0) {
+            thread_trace_event(THREAD_TRACE_BEGIN, phase_name(phase), -1);
+        }
+        trace_phase = phase;
+    }
+}
+
+// Generate this thread's block of the input (same blocks as the block
+// engine) and pad with INT_MAX past array_size. In file mode the block is
+// faulted in from the mapping instead. The engines' scratch buffer is
+// first-touched by the same threads inside libteamsort.
+void generate_block(int thread_id, int num_threads) {
+    struct timespec begin, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
     
-    int signals_blocked = 0;
+    int block_size = (padded_array_size + num_threads - 1) / num_threads;
+    long start = (long)thread_id * block_size;
+    long end = start + block_size;
+    if (start > padded_array_size) start = padded_array_size;
+    if (end > padded_array_size) end = padded_array_size;
+    long keys_end = end < array_size ? end : array_size;
     
-    // Block signals handled by other teams (but not by this team)
-    for (int other_team = 0; other_team < NUM_TEAMS; other_team++) {
-        if (other_team == team_id) continue;
-        
-        for (int i = 0; i < 3; i++) {
-            int other_signal = team_signals[other_team][i];
-            
-            // Check if current team also handles this signal
-            int handled_by_current_team = 0;
-            for (int j = 0; j < 3; j++) {
-                if (other_signal == team_signals[team_id][j]) {
-                    handled_by_current_team = 1;
-                    break;
-                }
-            }
-            
-            if (!handled_by_current_team) {
-                sigaddset(&block_set, other_signal);
-                signals_blocked++;
-            }
-        }
+    if (input_file) {
+        mapped_file_prefault(&mapped_input, start, keys_end);
+    } else if (start < keys_end) {
+        input_gen_fill(&input_gen, main_array + start, start, keys_end);
+    }
+    for (long i = (start > keys_end ? start : keys_end); i < end; i++) {
+        main_array[i] = INT_MAX;
     }
     
-    if (pthread_sigmask(SIG_BLOCK, &block_set, NULL) != 0) {
-        printf("[ERROR] Team %d: Failed to block signals: %s\n", team_id, strerror(errno));
-    } else {
-        printf("[SETUP] Team %d: Blocked %d signals from other teams\n", 
-               team_id, signals_blocked);
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    long elapsed = (end_time.tv_sec - begin.tv_sec) * 1000000000L + (end_time.tv_nsec - begin.tv_nsec);
+    long slowest = __atomic_load_n(&generate_ns_max, __ATOMIC_RELAXED);
+    while (elapsed > slowest &&
+           !__atomic_compare_exchange_n(&generate_ns_max, &slowest, elapsed, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
     }
 }
 
@@ -216,82 +387,407 @@ void* bitonic_thread_function(void* arg) {
         return NULL;
     }
     
-    printf("[BITONIC] Team %d Thread %d starting (array size: %d)\n", 
-           team->team_id, thread_index, padded_array_size);
+    thread_log(THREAD_LOG_DEBUG, "[BITONIC] Team %d Thread %d starting (array size: %d)\n", 
+               team->team_id, thread_index, padded_array_size);
     
-    setup_team_signals(team->team_id);
+    // The ring must exist before any of this thread's signals can arrive
+    if (trace_path) {
+        char name[32];
+        snprintf(name, sizeof(name), "Team %d Thread %d", team->team_id, thread_index);
+        if (thread_trace_register(team->team_id, name) != 0) {
+            printf("[ERROR] Team %d Thread %d: no trace buffer: %s\n",
+                   team->team_id, thread_index, strerror(errno));
+        }
+        thread_trace_event(THREAD_TRACE_INSTANT, "thread start", -1);
+    }
+    if (signal_log_register(team->team_id, thread_index) != 0) {
+        printf("[ERROR] Team %d Thread %d: no signal log ring left\n", team->team_id, thread_index);
+    }
+    if (!signal_dispatch_mode) {
+        setup_team_signals(team->team_id);
+    }
     
     // Calculate global thread ID
     int global_thread_id = team->team_id * team->num_threads + thread_index;
     int total_threads = NUM_TEAMS * threads_per_team;
+    perf_counters_t perf;
+    if (perf_mode != PERF_OFF) {
+        perf_counters_open(&perf, perf_mode == PERF_SOFTWARE);
+        perf_self = &perf;
+    }
     
-    printf("[BITONIC] Global thread %d (Team %d, Local %d) ready for parallel sorting\n", 
-           global_thread_id, team->team_id, thread_index);
+    thread_log(THREAD_LOG_DEBUG, "[BITONIC] Global thread %d (Team %d, Local %d) ready for parallel sorting\n", 
+               global_thread_id, team->team_id, thread_index);
     
-    // Record start time (only first thread)
-    if (global_thread_id == 0) {
-        clock_gettime(CLOCK_MONOTONIC, &team->start_time);
-        printf("[BITONIC] Starting parallel bitonic sort with %d threads\n", total_threads);
+    if (!service_endpoint && !external_mode) {
+        record_phase(NULL, global_thread_id, PERF_PHASE_INPUT);
+        generate_block(global_thread_id, total_threads);
+        record_phase(NULL, global_thread_id, PERF_PHASE_START_WAIT);
+        sort_barrier_wait(&start_barrier, global_thread_id);
     }
     
-    // All threads participate in parallel bitonic sort
-    bitonic_sort_parallel(main_array, 0, padded_array_size, 1, global_thread_id, total_threads);
+    // All threads participate in every sort main submits
+    teamsort_worker(sorter, global_thread_id);
+    if (signal_dispatch_mode) {
+        poll_team_signals(NULL, global_thread_id);
+    }
+    record_phase(NULL, global_thread_id, -1);
+    thread_trace_event(THREAD_TRACE_INSTANT, "thread exit", -1);
+    if (perf_self) {
+        perf_counters_close(&perf);
+        perf_self = NULL;
+        pthread_mutex_lock(&perf_lock);
+        perf_counts_merge(&perf_team_counts[team->team_id][perf.counts.mode], &perf.counts);
+        pthread_mutex_unlock(&perf_lock);
+    }
     
-    // Record completion time and verify (only first thread)
-    if (global_thread_id == 0) {
-        clock_gettime(CLOCK_MONOTONIC, &team->end_time);
-        
-        pthread_mutex_lock(&completion_mutex);
-        sort_completed = 1;
-        completion_order[0] = -1; // All teams collaborated
-        completion_index = 1;
-        
-        double elapsed = (team->end_time.tv_sec - team->start_time.tv_sec) + 
-                        (team->end_time.tv_nsec - team->start_time.tv_nsec) / 1e9;
+    thread_log(THREAD_LOG_DEBUG, "[BITONIC] Team %d Thread %d exiting\n", team->team_id, thread_index);
+    return NULL;
+}
+
+// Array mode: wait for the generated (or faulted-in) input, sort it on the
+// team threads and verify the result. Returns 1 if the result is sorted.
+int run_array_sort(void) {
+    int total_threads = NUM_TEAMS * threads_per_team;
+    team_data_t *team = &teams[0];
+    
+    // Wait until every team is up so the timing covers the sort only
+    sort_barrier_wait(&start_barrier, total_threads);
+    if (bench_num_rates > 0) {
+        memcpy(bench_input, main_array, (size_t)padded_array_size * sizeof(int));
+    }
+    mapped_file_fault_counts(&faults_loaded[0], &faults_loaded[1]);
+    clock_gettime(CLOCK_MONOTONIC, &team->start_time);
+    thread_log(THREAD_LOG_INFO, "[BITONIC] Starting %s with %d threads\n",
+               teamsort_engine_name(sort_algorithm), total_threads);
+    
+    thread_trace_event(THREAD_TRACE_BEGIN, "sort", -1);
+    if (teamsort_int32(sorter, main_array, padded_array_size) != 0) {
+        printf("[ERROR] Sort failed: %s\n", strerror(errno));
+        return 0;
+    }
+    thread_trace_event(THREAD_TRACE_END, "sort", -1);
+    
+    clock_gettime(CLOCK_MONOTONIC, &team->end_time);
+    mapped_file_fault_counts(&faults_sorted[0], &faults_sorted[1]);
+    thread_log_release();
+    
+    pthread_mutex_lock(&completion_mutex);
+    sort_completed = 1;
+    completion_order[0] = -1; // All teams collaborated
+    completion_index = 1;
+    for (int i = 0; i < NUM_TEAMS; i++) {
+        teams[i].completed = 1;
+    }
+    
+    teamsort_stats_t stats;
+    teamsort_get_stats(sorter, &stats);
+    double elapsed = (team->end_time.tv_sec - team->start_time.tv_sec) + 
+                    (team->end_time.tv_nsec - team->start_time.tv_nsec) / 1e9;
+    
+    printf("[COMPLETED] %s finished in %.6f seconds (%lld barrier stages)\n",
+           teamsort_engine_name(sort_algorithm), elapsed, stats.barrier_stages);
+    pthread_mutex_unlock(&completion_mutex);
+    
+    // Verify sort correctness
+    perf_counters_t perf;
+    if (perf_mode != PERF_OFF) {
+        perf_counters_open(&perf, perf_mode == PERF_SOFTWARE);
+        perf_counters_phase(&perf, PERF_PHASE_VERIFY);
+    }
+    thread_trace_event(THREAD_TRACE_BEGIN, "verify", -1);
+    int is_sorted = 1;
+    for (int i = 1; i < array_size; i++) {
+        if (main_array[i-1] > main_array[i]) {
+            is_sorted = 0;
+            printf("[VERIFY ERROR] Position %d: %d > %d\n", i, main_array[i-1], main_array[i]);
+            break;
+        }
+    }
+    thread_trace_event(THREAD_TRACE_END, "verify", -1);
+    if (perf_mode != PERF_OFF) {
+        perf_counters_close(&perf);
+        perf_counts_merge(&perf_main_counts[perf.counts.mode], &perf.counts);
+    }
+    printf("[VERIFY] Bitonic sort verification: %s\n", is_sorted ? "PASSED" : "FAILED");
+    
+    // Show sample of sorted array
+    printf("[RESULT] Sample sorted array: ");
+    int sample_size = (array_size < 20) ? array_size : 20;
+    for (int i = 0; i < sample_size; i++) {
+        printf("%d ", main_array[i]);
+    }
+    if (array_size > 20) printf("...");
+    printf("\n");
+    return is_sorted;
+}
+
+// "0,1000,1e4" -> bench_rates. Returns 0, or -1.
+int parse_bench_rates(const char *list) {
+    const char *p = list;
+    while (*p) {
+        char *end;
+        double rate = strtod(p, &end);
+        if (end == p || rate < 0 || bench_num_rates == BENCH_MAX_RATES) return -1;
+        bench_rates[bench_num_rates++] = rate;
+        p = end;
+        if (*p == ',') p++;
+        else if (*p) return -1;
+    }
+    return bench_num_rates > 0 ? 0 : -1;
+}
+
+// Queue signals to this process at bench_sender_rate until
+// bench_sender_stop: team 0's first signal, team 1's first, ..., then
+// every team's second, and so on. Tagged like signal_tester's load, so the
+// latency table covers them too. Runs with every signal blocked.
+void *bench_sender(void *arg) {
+    (void)arg;
+    static unsigned int seq[NSIG];
+    double rate = bench_sender_rate;
+    int burst = (int)(rate / BENCH_TICKS_PER_SEC) + 1;
+    long long tick_ns = (long long)(burst * 1e9 / rate);
+    pid_t self = getpid();
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    long long index = 0;
+    
+    while (!__atomic_load_n(&bench_sender_stop, __ATOMIC_ACQUIRE)) {
+        for (int b = 0; b < burst; b++, index++) {
+            int sig = team_signals[index % NUM_TEAMS][(index / NUM_TEAMS) % 3];
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            union sigval value;
+            value.sival_ptr = (void *)(intptr_t)signal_load_tag(seq[sig],
+                                  now.tv_sec * 1000000000LL + now.tv_nsec);
+            if (sigqueue(self, sig, value) == 0) {
+                seq[sig]++;
+                bench_sender_sent++;
+            }
+        }
+        long long next_ns = next.tv_nsec + tick_ns;
+        next.tv_sec += next_ns / 1000000000LL;
+        next.tv_nsec = next_ns % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+    }
+    return NULL;
+}
+
+// Sort the saved input bench_repeats times per rate and report the median
+// throughput against the signals each team took meanwhile
+void run_signal_bench(void) {
+    printf("\n=== SIGNAL LOAD BENCHMARK ===\n");
+    printf("%s, %d elements, %d threads, signals %s, median of %d runs per rate\n",
+           teamsort_engine_name(sort_algorithm), array_size, NUM_TEAMS * threads_per_team,
+           signal_dispatch_mode ? "polled by the team leaders" : "handled on team threads",
+           bench_repeats);
+    printf("%12s %12s %12s %14s %9s", "target sig/s", "sent sig/s", "taken sig/s",
+           "elements/s", "vs first");
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        printf("  team%d sig/s", t);
+    }
+    printf("\n");
+    
+    double *seconds = malloc(bench_repeats * sizeof(double));
+    if (!seconds) {
+        printf("[ERROR] Failed to allocate benchmark timings: %s\n", strerror(errno));
+        return;
+    }
+    double first_rate = 0;
+    struct timespec drain = {0, 2 * SIGNAL_LOG_POLL_NS};
+    
+    // One unmeasured run, so the first rate does not pay for cold caches
+    // and page faults in the scratch buffers
+    memcpy(main_array, bench_input, (size_t)padded_array_size * sizeof(int));
+    teamsort_int32(sorter, main_array, padded_array_size);
+    
+    for (int r = 0; r < bench_num_rates; r++) {
+        double rate = bench_rates[r];
+        long long sent = 0, taken[NUM_TEAMS] = {0};
+        double total_seconds = 0;
+        int sorted = 1;
         
-        printf("[COMPLETED] Parallel bitonic sort finished in %.6f seconds\n", elapsed);
-        pthread_mutex_unlock(&completion_mutex);
+        for (int rep = 0; rep < bench_repeats; rep++) {
+            memcpy(main_array, bench_input, (size_t)padded_array_size * sizeof(int));
+            long long before[NUM_TEAMS];
+            for (int t = 0; t < NUM_TEAMS; t++) {
+                before[t] = __atomic_load_n(&team_signal_events[t], __ATOMIC_RELAXED);
+            }
+            
+            pthread_t sender;
+            bench_sender_rate = rate;
+            bench_sender_stop = 0;
+            bench_sender_sent = 0;
+            if (rate > 0 && pthread_create(&sender, NULL, bench_sender, NULL) != 0) {
+                printf("[ERROR] Failed to start signal sender\n");
+                free(seconds);
+                return;
+            }
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (teamsort_int32(sorter, main_array, padded_array_size) != 0) {
+                printf("[ERROR] Sort failed: %s\n", strerror(errno));
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if (rate > 0) {
+                __atomic_store_n(&bench_sender_stop, 1, __ATOMIC_RELEASE);
+                pthread_join(sender, NULL);
+            }
+            
+            // Let the logger count what was delivered during the run
+            nanosleep(&drain, NULL);
+            seconds[rep] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            total_seconds += seconds[rep];
+            sent += bench_sender_sent;
+            for (int t = 0; t < NUM_TEAMS; t++) {
+                taken[t] += __atomic_load_n(&team_signal_events[t], __ATOMIC_RELAXED) - before[t];
+            }
+            for (int i = 1; i < array_size && sorted; i++) {
+                if (main_array[i - 1] > main_array[i]) sorted = 0;
+            }
+        }
         
-        // Verify sort correctness
-        int is_sorted = 1;
-        for (int i = 1; i < array_size; i++) {
-            if (main_array[i-1] > main_array[i]) {
-                is_sorted = 0;
-                printf("[VERIFY ERROR] Position %d: %d > %d\n", i, main_array[i-1], main_array[i]);
-                break;
+        // Median run time
+        for (int i = 1; i < bench_repeats; i++) {
+            double value = seconds[i];
+            int j = i - 1;
+            while (j >= 0 && seconds[j] > value) {
+                seconds[j + 1] = seconds[j];
+                j--;
             }
+            seconds[j + 1] = value;
         }
-        printf("[VERIFY] Bitonic sort verification: %s\n", is_sorted ? "PASSED" : "FAILED");
+        double median = seconds[bench_repeats / 2];
+        double elements_rate = array_size / median;
+        if (r == 0) first_rate = elements_rate;
         
-        // Show sample of sorted array
-        printf("[RESULT] Sample sorted array: ");
-        int sample_size = (array_size < 20) ? array_size : 20;
-        for (int i = 0; i < sample_size; i++) {
-            printf("%d ", main_array[i]);
+        long long taken_total = 0;
+        for (int t = 0; t < NUM_TEAMS; t++) {
+            taken_total += taken[t];
         }
-        if (array_size > 20) printf("...");
-        printf("\n");
+        printf("%12.0f %12.0f %12.0f %14.0f %8.1f%%", rate, sent / total_seconds,
+               taken_total / total_seconds, elements_rate, 100.0 * elements_rate / first_rate);
+        for (int t = 0; t < NUM_TEAMS; t++) {
+            printf(" %12.0f", taken[t] / total_seconds);
+        }
+        printf("%s\n", sorted ? "" : "  [VERIFY FAILED]");
+        fflush(stdout);
     }
-    
-    // Mark team completion for this thread's team
-    team->completed = 1;
-    
-    // All threads wait for global completion
-    while (!sort_completed) {
-        usleep(1000);
+    free(seconds);
+}
+
+// Phase classes of the per-team table: [first, last] phase
+static const struct {
+    const char *name;
+    int first;
+    int last;
+} perf_rows[] = {
+    {"input", PERF_PHASE_INPUT, PERF_PHASE_INPUT},
+    {"start wait", PERF_PHASE_START_WAIT, PERF_PHASE_START_WAIT},
+    {"local sort", TEAMSORT_PHASE_LOCAL, TEAMSORT_PHASE_LOCAL},
+    {"radix", TEAMSORT_PHASE_RADIX, TEAMSORT_PHASE_RADIX},
+    {"merges", TEAMSORT_PHASE_MERGE, TEAMSORT_PHASES - 1},
+    {"barrier wait", TEAMSORT_PHASE_BARRIER, TEAMSORT_PHASE_BARRIER},
+    {"idle", TEAMSORT_PHASE_IDLE, TEAMSORT_PHASE_IDLE},
+    {"verify", PERF_PHASE_VERIFY, PERF_PHASE_VERIFY},
+};
+
+// One table row: phases [first, last] of counts. Skipped if never entered.
+static void print_perf_row(const char *team, const char *phase, const perf_counts_t *counts,
+                           int first, int last) {
+    perf_phase_counts_t sum;
+    memset(&sum, 0, sizeof(sum));
+    for (int p = first; p <= last; p++) {
+        for (int e = 0; e < PERF_COUNTERS_EVENTS; e++) {
+            sum.values[e] += counts->phases[p].values[e];
+        }
+        sum.wall_ns += counts->phases[p].wall_ns;
+        sum.entries += counts->phases[p].entries;
     }
+    if (sum.entries == 0) return;
     
-    printf("[BITONIC] Team %d Thread %d exiting\n", team->team_id, thread_index);
-    return NULL;
+    printf("  %-6s %-12s %12.3f", team, phase, sum.wall_ns / 1e6);
+    for (int e = 0; e < PERF_COUNTERS_EVENTS; e++) {
+        if (counts->available & (1u << e)) {
+            printf(" %14lld", sum.values[e]);
+        } else {
+            printf(" %14s", "n/a");
+        }
+    }
+    if (counts->mode == PERF_COUNTERS_HARDWARE && (counts->available & 3) == 3) {
+        printf(" %6.2f", sum.values[0] > 0 ? (double)sum.values[1] / sum.values[0] : 0.0);
+    }
+    printf("\n");
+}
+
+// Per team and phase class, then per merge level over all teams, for each
+// counter mode that some thread ended up in
+void print_perf_summary(void) {
+    for (int mode = PERF_COUNTERS_HARDWARE; mode >= PERF_COUNTERS_SOFTWARE; mode--) {
+        perf_counts_t all;
+        perf_counts_init(&all, mode);
+        all.threads = 0;
+        for (int i = 0; i < NUM_TEAMS; i++) {
+            if (perf_team_counts[i][mode].threads > 0) {
+                perf_counts_merge(&all, &perf_team_counts[i][mode]);
+            }
+        }
+        if (perf_main_counts[mode].threads > 0) {
+            perf_counts_merge(&all, &perf_main_counts[mode]);
+        }
+        if (all.threads == 0) continue;
+        
+        printf("Performance counters (%s, %d threads; thread ms summed over threads):\n",
+               mode == PERF_COUNTERS_HARDWARE ? "perf_event_open" : "software fallback",
+               all.threads);
+        if (mode == PERF_COUNTERS_HARDWARE && all.running_ns < all.enabled_ns) {
+            printf("  Counters multiplexed: counting %.1f%% of the time, counts not scaled\n",
+                   all.enabled_ns > 0 ? 100.0 * all.running_ns / all.enabled_ns : 0.0);
+        }
+        printf("  %-6s %-12s %12s", "team", "phase", "thread ms");
+        for (int e = 0; e < PERF_COUNTERS_EVENTS; e++) {
+            printf(" %14s", perf_counters_event_name(mode, e));
+        }
+        if (mode == PERF_COUNTERS_HARDWARE && (all.available & 3) == 3) {
+            printf(" %6s", "IPC");
+        }
+        printf("\n");
+        
+        int num_rows = sizeof(perf_rows) / sizeof(perf_rows[0]);
+        for (int i = 0; i < NUM_TEAMS; i++) {
+            const perf_counts_t *counts = &perf_team_counts[i][mode];
+            if (counts->threads == 0) continue;
+            char team[16];
+            snprintf(team, sizeof(team), "%d", i);
+            for (int r = 0; r < num_rows; r++) {
+                print_perf_row(team, perf_rows[r].name, counts, perf_rows[r].first, perf_rows[r].last);
+            }
+        }
+        if (perf_main_counts[mode].threads > 0) {
+            print_perf_row("main", "verify", &perf_main_counts[mode], PERF_PHASE_VERIFY,
+                           PERF_PHASE_VERIFY);
+        }
+        
+        // Merge levels: k counts elements for the bitonic engine, blocks for
+        // the block engine
+        for (int p = TEAMSORT_PHASE_MERGE; p < TEAMSORT_PHASES; p++) {
+            char level[16];
+            snprintf(level, sizeof(level), "k=2^%d", p - TEAMSORT_PHASE_MERGE);
+            print_perf_row("all", level, &all, p, p);
+        }
+    }
 }
 
 void setup_signal_handlers() {
     printf("[SETUP] Setting up signal handlers\n");
     
+    // Handled signals are blocked while the handler runs, so handlers never
+    // nest on a thread and each signal ring has a single producer
     struct sigaction sa;
-    sa.sa_handler = signal_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = SA_RESTART;
+    sa.sa_sigaction = signal_handler;
+    sigfillset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART | SA_SIGINFO;
     
     int all_signals[] = {SIGINT, SIGABRT, SIGILL, SIGCHLD, SIGSEGV, SIGFPE, SIGHUP, SIGTSTP};
     int num_signals = sizeof(all_signals) / sizeof(all_signals[0]);
@@ -310,44 +806,106 @@ void setup_signal_handlers() {
 
 
 void initialize_array() {
-    // Calculate padded size for bitonic sort (must be power of 2)
-    padded_array_size = next_power_of_2(array_size);
+    // The network handles any length; padding is only kept for comparison
+    padded_array_size = pad_to_power_of_2 ? next_power_of_2(array_size) : array_size;
     
-    printf("[INIT] Original array size: %d, Padded to: %d (power of 2)\n", 
-           array_size, padded_array_size);
-    
-    main_array = malloc(padded_array_size * sizeof(int));
-    if (!main_array) {
-        printf("[ERROR] Failed to allocate memory: %s\n", strerror(errno));
-        exit(1);
+    if (pad_to_power_of_2) {
+        printf("[INIT] Original array size: %d, Padded to: %d (power of 2)\n", 
+               array_size, padded_array_size);
+    } else {
+        printf("[INIT] Array size: %d (arbitrary-length network, no padding)\n", array_size);
     }
     
-    srand(time(NULL));
-    
-    // Fill original array with random values
-    for (int i = 0; i < array_size; i++) {
-        main_array[i] = rand() % 10000;
+    // The keys are sorted where they are mapped, never copied
+    if (input_file) {
+        main_array = mapped_input.keys;
+        printf("[INIT] Input: %d keys mapped from %s (huge pages %s)\n", array_size, input_file,
+               mapped_input.hugepages ? "advised" : "not available");
+    } else {
+        main_array = malloc(padded_array_size * sizeof(int));
+        if (!main_array) {
+            printf("[ERROR] Failed to allocate memory: %s\n", strerror(errno));
+            exit(1);
+        }
+        
+        // The sort threads generate their own blocks when they start
+        if (!input_seed_given) {
+            input_seed = (unsigned long long)time(NULL);
+        }
+        if (input_gen_init(&input_gen, input_dist, input_seed, array_size, KEY_RANGE) != 0) {
+            printf("[ERROR] Failed to set up input generator: %s\n", strerror(errno));
+            exit(1);
+        }
+        printf("[INIT] Input: %d %s keys in [0, %d), seed %llu (rerun with --seed=%llu)\n",
+               array_size, input_dist_name(input_dist), KEY_RANGE, input_seed, input_seed);
     }
-    
-    // Pad with maximum values to ensure they sort to the end
-    for (int i = array_size; i < padded_array_size; i++) {
-        main_array[i] = INT_MAX;
+    if (pad_to_power_of_2) {
+        printf("[INIT] Padding with %d max values\n", padded_array_size - array_size);
+    }
+    if (bench_num_rates > 0) {
+        bench_input = malloc(padded_array_size * sizeof(int));
+        if (!bench_input) {
+            printf("[ERROR] Failed to allocate benchmark input: %s\n", strerror(errno));
+            exit(1);
+        }
     }
     
-    printf("[INIT] Generated %d random integers, padded with %d max values\n", 
-           array_size, padded_array_size - array_size);
+    // The block engine merge-splits into a second buffer of the same size,
+    // which libteamsort allocates on the first sort
+    if (sort_algorithm == TEAMSORT_BLOCK) {
+        int total_threads = NUM_TEAMS * threads_per_team;
+        printf("[INIT] Block-bitonic: %d blocks of up to %d elements\n", total_threads,
+               (padded_array_size + total_threads - 1) / total_threads);
+    }
+}
+
+// Service and external modes have no array of their own; jobs bring their data
+void initialize_service() {
+    if (external_mode) {
+        printf("[INIT] External sort of %s: %zu bytes of buffers, temp files in %s\n",
+               input_file, external_mem_limit, external_temp_dir);
+    } else {
+        printf("[INIT] Service mode: sorting jobs from %s\n", service_endpoint);
+    }
+    padded_array_size = 0;
 }
 
 void create_teams() {
     printf("[INIT] Creating %d teams with %d threads each for parallel bitonic sort\n", NUM_TEAMS, threads_per_team);
     
-    // Initialize global barrier for thread synchronization
+    // Sort context shared by all teams: stage barrier, dispatch barrier,
+    // radix tables and scratch
     int total_threads = NUM_TEAMS * threads_per_team;
-    if (pthread_barrier_init(&global_barrier, NULL, total_threads) != 0) {
-        printf("[ERROR] Failed to initialize global barrier: %s\n", strerror(errno));
+    if (barrier_spin_limit < 0) {
+        barrier_spin_limit = sort_barrier_default_spin(total_threads);
+    }
+    // A single array is always sorted by every team, however small
+    int array_mode = !service_endpoint && !external_mode;
+    teamsort_config_t config = {
+        total_threads, sort_algorithm, barrier_kind, barrier_spin_limit, kernel_set,
+        array_mode ? 1 : 0, signal_dispatch_mode ? poll_team_signals : NULL, NULL,
+        perf_mode != PERF_OFF || trace_path ? record_phase : NULL, NULL
+    };
+    sorter = teamsort_create(&config);
+    if (!sorter) {
+        printf("[ERROR] Failed to initialize sort context: %s\n", strerror(errno));
         exit(1);
     }
-    printf("[INIT] Global barrier initialized for %d threads\n", total_threads);
+    printf("[INIT] Global %s barrier initialized for %d threads (spin budget %ld)\n",
+           sort_barrier_kind_name(barrier_kind), total_threads, barrier_spin_limit);
+    
+    if (array_mode &&
+        sort_barrier_init(&start_barrier, barrier_kind, total_threads + 1, barrier_spin_limit) != 0) {
+        printf("[ERROR] Failed to initialize start barrier: %s\n", strerror(errno));
+        exit(1);
+    }
+    
+    signal_routes_init(&signal_routes, NUM_TEAMS);
+    for (int i = 0; i < NUM_TEAMS; i++) {
+        for (int j = 0; j < 3; j++) {
+            signal_routes_add(&signal_routes, i, team_signals[i][j]);
+        }
+    }
     
     for (int i = 0; i < NUM_TEAMS; i++) {
         teams[i].team_id = i;
@@ -380,6 +938,13 @@ void print_status() {
     printf("Array size: %d elements\n", array_size);
     printf("Teams: %d\n", NUM_TEAMS);
     printf("Threads per team: %d\n", threads_per_team);
+    printf("Signal delivery: %s\n", signal_dispatch_mode ?
+           "dispatcher thread, polled at stage boundaries" : "handler on a team thread");
+    if (perf_mode != PERF_OFF) {
+        printf("Performance counters: %s\n", perf_mode == PERF_AUTO ?
+               "hardware events, software fallback" : "software");
+    }
+    printf("Log level: %s\n", thread_log_level_name(log_level));
     
     printf("\nSignal assignments:\n");
     for (int i = 0; i < NUM_TEAMS; i++) {
@@ -392,27 +957,282 @@ void print_status() {
     printf("=====================\n\n");
 }
 
+void print_usage(const char *prog) {
+    printf("Usage: %s [options] [array_size] [threads_per_team]\n", prog);
+    printf("Options:\n");
+    printf("  --algo=NAME  Sorting engine: bitonic (default), block (local sort + block network)\n");
+    printf("               or radix (counting sort / LSD radix over the key range)\n");
+    printf("  --padded     Pad the array to a power of 2 with INT_MAX (classic network)\n");
+    printf("  --barrier=K  Stage barrier: futex (spin-then-futex, default) or pthread\n");
+    printf("  --spin=N     Spin iterations before a futex barrier sleeps (default depends on CPUs)\n");
+    printf("  --serve=EP   Run as a sort service on EP: 'stdin' or a Unix socket path\n");
+    printf("  --isa=NAME   Compare-exchange kernels: auto (default), scalar, sse4.1, avx2, avx512\n");
+    printf("  --isa-check  Check every supported kernel set against scalar and exit\n");
+    printf("  --placement=MODE\n");
+    printf("               Pin teams: none (default), cores (one core set per team) or numa\n");
+    printf("               (one NUMA node per team); threads then first-touch their blocks\n");
+    printf("  --seed=N     Input seed (default: time-based, printed so a run can be repeated)\n");
+    printf("  --dist=NAME  Input keys: uniform (default), sorted, reversed, few-unique, zipf\n");
+    printf("               or organ-pipe\n");
+    printf("  --file=PATH  Sort a binary int32 file in place through a shared mapping\n");
+    printf("               (array_size is taken from the file)\n");
+    printf("  --external   With --file: external merge sort for files larger than memory\n");
+    printf("  --mem-limit=SIZE\n");
+    printf("               External sort buffer memory, e.g. 512M or 2G (default 256M)\n");
+    printf("  --temp-dir=DIR\n");
+    printf("               Directory for external sort runs (default /tmp)\n");
+    printf("  --signals=MODE\n");
+    printf("               Signal delivery: handler (default, interrupts a team thread) or dispatch\n");
+    printf("               (dispatcher thread, teams poll mailboxes between sort stages)\n");
+    printf("  --bench-signals=RATES\n");
+    printf("               After the sort, sort the same input again while a sender thread queues\n");
+    printf("               the teams' signals at each rate (signals/sec, e.g. 0,1000,10000) and\n");
+    printf("               report elements/sec per rate and the signals each team took\n");
+    printf("  --bench-repeats=N\n");
+    printf("               Runs per rate for --bench-signals, median reported (default 3)\n");
+    printf("  --perf=MODE  Count per thread and phase: auto (hardware events through\n");
+    printf("               perf_event_open, software counters where unavailable) or software\n");
+    printf("  --trace=FILE Record per-thread phases, barriers and signal handlers and write them\n");
+    printf("               as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)\n");
+    printf("  --trace-events=N\n");
+    printf("               Trace buffer size per thread, in events (default %d)\n",
+           TRACE_DEFAULT_EVENTS);
+    printf("  --log=LEVEL  Progress output: quiet, info (default; held until the sort is done)\n");
+    printf("               or debug (every thread's lines, as they come)\n");
+    printf("  -h, --help   Show this help\n");
+}
+
 int main(int argc, char *argv[]) {
     printf("=== ECE 434 Project 1: Thread Teams with Signal Handling ===\n");
     printf("Process PID: %d\n", getpid());
     
-    // Parse command line arguments
-    if (argc > 1) {
-        array_size = atoi(argv[1]);
+    // Parse command line options
+    static struct option long_options[] = {
+        {"algo",   required_argument, NULL, 'a'},
+        {"padded", no_argument, NULL, 'p'},
+        {"barrier", required_argument, NULL, 'b'},
+        {"spin",   required_argument, NULL, 's'},
+        {"serve",  required_argument, NULL, 'S'},
+        {"isa",    required_argument, NULL, 'i'},
+        {"isa-check", no_argument, NULL, 'c'},
+        {"placement", required_argument, NULL, 'P'},
+        {"seed",   required_argument, NULL, 'r'},
+        {"dist",   required_argument, NULL, 'd'},
+        {"file",   required_argument, NULL, 'f'},
+        {"external", no_argument, NULL, 'x'},
+        {"mem-limit", required_argument, NULL, 'm'},
+        {"temp-dir", required_argument, NULL, 'T'},
+        {"signals", required_argument, NULL, 'g'},
+        {"bench-signals", required_argument, NULL, 'B'},
+        {"bench-repeats", required_argument, NULL, 'R'},
+        {"perf",   required_argument, NULL, 'E'},
+        {"trace",  required_argument, NULL, 'o'},
+        {"trace-events", required_argument, NULL, 'n'},
+        {"log",    required_argument, NULL, 'L'},
+        {"help",   no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'a':
+            if (strcmp(optarg, "bitonic") == 0) {
+                sort_algorithm = TEAMSORT_BITONIC;
+            } else if (strcmp(optarg, "block") == 0) {
+                sort_algorithm = TEAMSORT_BLOCK;
+            } else if (strcmp(optarg, "radix") == 0) {
+                sort_algorithm = TEAMSORT_RADIX;
+            } else {
+                printf("[ERROR] Unknown algorithm: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'p':
+            pad_to_power_of_2 = 1;
+            break;
+        case 'b':
+            if (strcmp(optarg, "futex") == 0) {
+                barrier_kind = SORT_BARRIER_FUTEX;
+            } else if (strcmp(optarg, "pthread") == 0) {
+                barrier_kind = SORT_BARRIER_PTHREAD;
+            } else {
+                printf("[ERROR] Unknown barrier: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            barrier_spin_limit = atol(optarg);
+            if (barrier_spin_limit < 0) {
+                printf("[ERROR] Invalid spin budget: %ld\n", barrier_spin_limit);
+                return 1;
+            }
+            break;
+        case 'S':
+            service_endpoint = optarg;
+            break;
+        case 'i':
+            kernel_set = optarg;
+            if (!bitonic_select_kernels(kernel_set)) {
+                printf("[ERROR] Kernel set '%s' is unknown or not supported by this CPU\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            return bitonic_kernels_selftest(1 << 16);
+        case 'P':
+            placement_mode = team_placement_parse(optarg);
+            if (placement_mode < 0) {
+                printf("[ERROR] Unknown placement: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            input_seed = strtoull(optarg, NULL, 0);
+            input_seed_given = 1;
+            break;
+        case 'd':
+            input_dist = input_dist_parse(optarg);
+            if (input_dist < 0) {
+                printf("[ERROR] Unknown distribution: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'f':
+            input_file = optarg;
+            break;
+        case 'x':
+            external_mode = 1;
+            break;
+        case 'm':
+            external_mem_limit = external_sort_parse_size(optarg);
+            if (external_mem_limit == 0) {
+                printf("[ERROR] Invalid memory limit: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'T':
+            external_temp_dir = optarg;
+            break;
+        case 'B':
+            if (parse_bench_rates(optarg) != 0) {
+                printf("[ERROR] Invalid signal rates: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'R':
+            bench_repeats = atoi(optarg);
+            if (bench_repeats <= 0 || bench_repeats > 1000) {
+                printf("[ERROR] Invalid repeat count: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            trace_path = optarg;
+            break;
+        case 'n':
+            trace_events = atol(optarg);
+            if (trace_events <= 0) {
+                printf("[ERROR] Invalid trace buffer size: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'L':
+            log_level = thread_log_parse(optarg);
+            if (log_level < 0) {
+                printf("[ERROR] Unknown log level: %s (use quiet, info or debug)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'E':
+            if (strcmp(optarg, "auto") == 0) {
+                perf_mode = PERF_AUTO;
+            } else if (strcmp(optarg, "software") == 0) {
+                perf_mode = PERF_SOFTWARE;
+            } else {
+                printf("[ERROR] Unknown perf mode: %s (use auto or software)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'g':
+            if (strcmp(optarg, "handler") == 0) {
+                signal_dispatch_mode = 0;
+            } else if (strcmp(optarg, "dispatch") == 0) {
+                signal_dispatch_mode = 1;
+            } else {
+                printf("[ERROR] Unknown signal mode: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'h':
+        default:
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    // Positional arguments: <array_size> <threads_per_team>. With --file the
+    // size comes from the file and the first argument is a placeholder.
+    if (optind < argc && !input_file) {
+        array_size = atoi(argv[optind]);
         if (array_size <= 0 || array_size > 10000000) {
             printf("[ERROR] Invalid array size: %d\n", array_size);
             return 1;
         }
     }
-    if (argc > 2) {
-        threads_per_team = atoi(argv[2]);
+    if (optind + 1 < argc) {
+        threads_per_team = atoi(argv[optind + 1]);
         if (threads_per_team <= 0 || threads_per_team > 10000) {
             printf("[ERROR] Invalid threads per team: %d\n", threads_per_team);
             return 1;
         }
     }
     
-    printf("[CONFIG] Array: %d elements, Threads per team: %d\n", array_size, threads_per_team);
+    // The mapping is exactly the file: no room for padding, no service jobs
+    if (external_mode && !input_file) {
+        printf("[ERROR] --external needs an input --file\n");
+        return 1;
+    }
+    if (bench_num_rates > 0 && (service_endpoint || external_mode)) {
+        printf("[ERROR] --bench-signals sorts one array; it cannot be combined with --serve or --external\n");
+        return 1;
+    }
+    if (input_file) {
+        if (pad_to_power_of_2 || service_endpoint) {
+            printf("[ERROR] --file cannot be combined with --padded or --serve\n");
+            return 1;
+        }
+    }
+    if (input_file && !external_mode) {
+        struct timespec map_start, map_end;
+        clock_gettime(CLOCK_MONOTONIC, &map_start);
+        if (mapped_file_open(&mapped_input, input_file, TEAMSORT_MAX_N) != 0) {
+            printf("[ERROR] Failed to map %s: %s\n", input_file, strerror(errno));
+            return 1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &map_end);
+        file_map_seconds = (map_end.tv_sec - map_start.tv_sec) +
+                           (map_end.tv_nsec - map_start.tv_nsec) / 1e9;
+        array_size = (int)mapped_input.count;
+    }
+    
+    // Claim the endpoint before any thread starts printing
+    if (service_endpoint && sort_service_open(service_endpoint) != 0) {
+        return 1;
+    }
+    
+    if (external_mode) {
+        printf("[CONFIG] External sort: %s, Threads per team: %d\n", input_file, threads_per_team);
+    } else {
+        printf("[CONFIG] Array: %d elements, Threads per team: %d, Padding: %s\n",
+               array_size, threads_per_team, pad_to_power_of_2 ? "power of 2" : "none");
+    }
+    printf("[CONFIG] Compare-exchange kernels: %s\n", bitonic_select_kernels(kernel_set)->name);
+    
+    if (team_placement_init(&placement, placement_mode, NUM_TEAMS) != 0) {
+        printf("[ERROR] Failed to read CPU topology: %s\n", strerror(errno));
+        return 1;
+    }
+    team_placement_print(&placement);
     
     int total_threads = NUM_TEAMS * threads_per_team;
     if (total_threads > 1000) {
@@ -429,24 +1249,87 @@ int main(int argc, char *argv[]) {
     printf("[SETUP] All signals blocked in main thread\n");
     
     // Initialize array and teams
-    initialize_array();
+    if (service_endpoint || external_mode) {
+        initialize_service();
+    } else {
+        initialize_array();
+    }
+    for (int i = 0; i < NUM_TEAMS; i++) {
+        perf_counts_init(&perf_team_counts[i][PERF_COUNTERS_SOFTWARE], PERF_COUNTERS_SOFTWARE);
+        perf_counts_init(&perf_team_counts[i][PERF_COUNTERS_HARDWARE], PERF_COUNTERS_HARDWARE);
+    }
+    perf_counts_init(&perf_main_counts[PERF_COUNTERS_SOFTWARE], PERF_COUNTERS_SOFTWARE);
+    perf_counts_init(&perf_main_counts[PERF_COUNTERS_HARDWARE], PERF_COUNTERS_HARDWARE);
     create_teams();
     print_status();
     
-    // Setup signal handlers (process-wide)
-    setup_signal_handlers();
+    // Main's track sits in its own group after the teams
+    if (trace_path) {
+        for (int i = 0; i < 32; i++) {
+            snprintf(merge_phase_names[i], sizeof(merge_phase_names[i]), "merge 2^%d", i);
+        }
+        if (thread_trace_start(total_threads + 1, trace_events) != 0 ||
+            thread_trace_register(NUM_TEAMS, "main") != 0) {
+            printf("[ERROR] Failed to start tracing: %s\n", strerror(errno));
+            return 1;
+        }
+        for (int i = 0; i < NUM_TEAMS; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "Team %d", i);
+            thread_trace_name_group(i, name);
+        }
+        thread_trace_name_group(NUM_TEAMS, "Main");
+    }
+    
+    // The logger thread inherits main's mask, so it never takes a signal
+    signal_load_init(&signal_load);
+    if (signal_log_start(total_threads, report_signal) != 0) {
+        printf("[ERROR] Failed to start signal logger: %s\n", strerror(errno));
+        return 1;
+    }
+    if (thread_log_start(log_level, total_threads + 4) != 0) {
+        printf("[ERROR] Failed to start log writer: %s\n", strerror(errno));
+        return 1;
+    }
+    
+    // Setup signal handlers (process-wide), or leave every signal blocked
+    // and route them through the dispatcher
+    if (signal_dispatch_mode) {
+        if (signal_dispatch_start(&signal_routes) != 0) {
+            printf("[ERROR] Failed to start signal dispatcher: %s\n", strerror(errno));
+            return 1;
+        }
+        printf("[SETUP] Signal dispatcher started, team threads keep all signals blocked\n");
+    } else {
+        setup_signal_handlers();
+    }
     
     // Create and start teams
     struct timespec program_start, program_end;
     clock_gettime(CLOCK_MONOTONIC, &program_start);
     
     printf("[STARTING] Creating %d teams...\n", NUM_TEAMS);
+    fflush(stdout);
+    if (log_level < THREAD_LOG_DEBUG) {
+        thread_log_hold();
+    }
+    mapped_file_fault_counts(&faults_start[0], &faults_start[1]);
+    thread_trace_event(THREAD_TRACE_BEGIN, "create threads", -1);
     
     for (int i = 0; i < NUM_TEAMS; i++) {
-        printf("[TEAM %d] Creating %d threads...\n", i, teams[i].num_threads);
+        thread_log(THREAD_LOG_INFO, "[TEAM %d] Creating %d threads...\n", i, teams[i].num_threads);
+        
+        // Pinned teams start on their own CPU set
+        pthread_attr_t team_attr;
+        pthread_attr_init(&team_attr);
+        int placed = team_placement_apply(&placement, i, &team_attr);
+        if (placed != 0) {
+            printf("[ERROR] Failed to set CPU affinity for team %d: %s\n", i, strerror(placed));
+            return 1;
+        }
         
         for (int j = 0; j < teams[i].num_threads; j++) {
-            int result = pthread_create(&teams[i].threads[j], NULL, 
+            int result = pthread_create(&teams[i].threads[j], &team_attr, 
                                       bitonic_thread_function, &teams[i]);
             if (result != 0) {
                 printf("[ERROR] Failed to create thread %d for team %d: %s\n", 
@@ -455,18 +1338,55 @@ int main(int argc, char *argv[]) {
             }
         }
         
-        printf("[TEAM %d] All %d threads created successfully\n", i, teams[i].num_threads);
+        pthread_attr_destroy(&team_attr);
+        thread_log(THREAD_LOG_INFO, "[TEAM %d] All %d threads created successfully\n",
+                   i, teams[i].num_threads);
         
         // Small delay between team creation to see startup clearly
         usleep(100000); // 100ms
     }
+    thread_trace_event(THREAD_TRACE_END, "create threads", -1);
+    
+    thread_log(THREAD_LOG_INFO, "[READY] All teams created. Ready to receive signals!\n");
+    thread_log(THREAD_LOG_INFO, "[INFO] Send signals using: kill -<signal> %d\n", getpid());
+    thread_log(THREAD_LOG_INFO, "[INFO] Or use: ./signal_tester %d <signal_number>\n", getpid());
+    thread_log(THREAD_LOG_INFO, "[INFO] Available signals: SIGINT(2), SIGABRT(6), SIGILL(4), SIGCHLD(17), SIGSEGV(11), SIGFPE(8), SIGHUP(1), SIGTSTP(20)\n");
+    
+    // Service and external runs have no single timed sort to wait for
+    if (service_endpoint || external_mode) {
+        thread_log_release();
+    }
     
-    printf("[READY] All teams created. Ready to receive signals!\n");
-    printf("[INFO] Send signals using: kill -<signal> %d\n", getpid());
-    printf("[INFO] Or use: ./signal_tester %d <signal_number>\n", getpid());
-    printf("[INFO] Available signals: SIGINT(2), SIGABRT(6), SIGILL(4), SIGCHLD(17), SIGSEGV(11), SIGFPE(8), SIGHUP(1), SIGTSTP(20)\n");
+    // Service mode: feed job batches to the warm pool until shutdown
+    sort_service_stats_t service_stats;
+    if (service_endpoint) {
+        sort_service_run(run_service_batch, SERVICE_MAX_BATCH, &service_stats);
+    }
+    
+    // External mode: runs go through the same warm pool
+    external_sort_stats_t external_stats;
+    int external_ok = 0;
+    if (external_mode) {
+        external_sort_config_t config = {
+            input_file, external_temp_dir, external_mem_limit,
+            sort_algorithm != TEAMSORT_BITONIC
+        };
+        external_ok = external_sort(&config, run_service_batch, &external_stats) == 0;
+    }
+    
+    int array_ok = 0;
+    if (!service_endpoint && !external_mode) {
+        array_ok = run_array_sort();
+        if (bench_num_rates > 0 && sort_completed) {
+            run_signal_bench();
+        }
+    }
+    
+    // Release the team threads from the sort pool
+    teamsort_stop(sorter);
     
     // Wait for all teams to complete
+    thread_trace_event(THREAD_TRACE_BEGIN, "join", -1);
     int teams_joined = 0;
     for (int i = 0; i < NUM_TEAMS; i++) {
         printf("[JOINING] Waiting for team %d threads to complete...\n", i);
@@ -483,6 +1403,41 @@ int main(int argc, char *argv[]) {
         teams_joined++;
         printf("[JOINED] Team %d completed (%d/%d teams done)\n", i, teams_joined, NUM_TEAMS);
     }
+    thread_trace_event(THREAD_TRACE_END, "join", -1);
+    if (trace_path) {
+        long dropped;
+        long written = thread_trace_write(trace_path, &dropped);
+        if (written < 0) {
+            printf("[ERROR] Failed to write trace %s: %s\n", trace_path, strerror(errno));
+        } else {
+            printf("[TRACE] %ld events written to %s", written, trace_path);
+            if (dropped > 0) {
+                printf(", %ld dropped (buffer full, raise --trace-events)", dropped);
+            }
+            printf("\n");
+        }
+        thread_trace_stop();
+    }
+    
+    signal_dispatch_stats_t dispatch_stats;
+    if (signal_dispatch_mode) {
+        signal_dispatch_stop(&dispatch_stats);
+    }
+    signal_log_stats_t signal_stats;
+    signal_log_stop(&signal_stats);
+    thread_log_stop();
+    
+    if (input_file && !external_mode && sort_completed) {
+        struct timespec sync_start, sync_end;
+        clock_gettime(CLOCK_MONOTONIC, &sync_start);
+        if (mapped_file_sync(&mapped_input) != 0) {
+            printf("[ERROR] Failed to write back %s: %s\n", input_file, strerror(errno));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &sync_end);
+        file_sync_seconds = (sync_end.tv_sec - sync_start.tv_sec) +
+                            (sync_end.tv_nsec - sync_start.tv_nsec) / 1e9;
+        printf("[FILE] Sorted keys written back to %s\n", input_file);
+    }
     
     clock_gettime(CLOCK_MONOTONIC, &program_end);
     double total_time = (program_end.tv_sec - program_start.tv_sec) + 
@@ -491,21 +1446,145 @@ int main(int argc, char *argv[]) {
     // Print final results
     printf("\n=== FINAL RESULTS ===\n");
     printf("Total execution time: %.6f seconds\n", total_time);
+    printf("Signals: %lld received, %lld dropped (ring full), %lld on unregistered threads",
+           signal_stats.events, signal_stats.dropped, signal_stats.unregistered);
+    if (signal_stats.events > signal_stats.dropped + signal_stats.unregistered) {
+        printf(", handler avg %.0f ns, max %lld ns",
+               (double)signal_stats.handler_ns_total /
+                   (signal_stats.events - signal_stats.dropped - signal_stats.unregistered),
+               signal_stats.handler_ns_max);
+    }
+    printf("\n");
+    if (signal_dispatch_mode) {
+        printf("Signal dispatch: %lld read, %lld unrouted, %lld posted to teams "
+               "(%lld dropped, mailbox full), %lld taken at stage boundaries, %lld left pending",
+               dispatch_stats.received, dispatch_stats.unrouted, dispatch_stats.posted,
+               dispatch_stats.dropped, dispatch_stats.delivered, dispatch_stats.pending);
+        if (dispatch_stats.delivered > 0) {
+            printf(", mailbox latency avg %.1f us, max %.1f us",
+                   dispatch_stats.latency_ns_total / 1e3 / dispatch_stats.delivered,
+                   dispatch_stats.latency_ns_max / 1e3);
+        }
+        printf("\n");
+    }
+    signal_load_print(&signal_load);
     
-    if (sort_completed) {
+    if (service_endpoint) {
+        printf("Sort service results:\n");
+        printf("  Algorithm: %s (jobs below %d elements sorted by a single thread)\n",
+               teamsort_engine_name(sort_algorithm), TEAMSORT_SMALL_JOB);
+        printf("  Jobs: %lld in %lld batches (%.1f jobs per batch), %lld elements\n",
+               service_stats.jobs, service_stats.batches,
+               service_stats.batches > 0 ? (double)service_stats.jobs / service_stats.batches : 0.0,
+               service_stats.elements);
+        if (service_stats.busy_seconds > 0) {
+            printf("  Throughput: %.1f jobs/sec, %.0f elements/sec\n",
+                   service_stats.jobs / service_stats.busy_seconds,
+                   service_stats.elements / service_stats.busy_seconds);
+        }
+        printf("  Job latency: avg %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+               service_stats.latency_avg_us, service_stats.latency_p50_us,
+               service_stats.latency_p99_us, service_stats.latency_max_us);
+    } else if (external_mode && external_ok) {
+        printf("External sort results:\n");
+        printf("  Algorithm: %s for runs, %d-way loser-tree merge\n",
+               teamsort_engine_name(sort_algorithm), external_stats.fan_in);
+        printf("  Keys: %lld in %d runs of up to %ld keys (memory limit %zu bytes)\n",
+               external_stats.keys, external_stats.runs, external_stats.run_keys, external_mem_limit);
+        printf("  Run formation: %.6f s (sorting %.6f s, waiting for I/O %.6f s)\n",
+               external_stats.run_seconds, external_stats.sort_seconds,
+               external_stats.run_io_wait_seconds);
+        if (external_stats.merge_passes > 0) {
+            printf("  Merge: %d passes in %.6f s (waiting for I/O %.6f s, %ld-key buffers)\n",
+                   external_stats.merge_passes, external_stats.merge_seconds,
+                   external_stats.merge_io_wait_seconds, external_stats.merge_block_keys);
+        } else {
+            printf("  Merge: none, the single run was written straight back\n");
+        }
+        printf("  I/O: %.1f MB read, %.1f MB written\n",
+               external_stats.bytes_read / 1e6, external_stats.bytes_written / 1e6);
+        printf("[VERIFY] External sort output sorted: %s, keys preserved: %s\n",
+               external_stats.sorted ? "PASSED" : "FAILED",
+               external_stats.keys_preserved ? "PASSED" : "FAILED");
+    } else if (sort_completed) {
         double sort_time = (teams[0].end_time.tv_sec - teams[0].start_time.tv_sec) + 
                           (teams[0].end_time.tv_nsec - teams[0].start_time.tv_nsec) / 1e9;
         
-        printf("Parallel bitonic sort results:\n");
-        printf("  Algorithm: Parallel Bitonic Sort\n");
+        teamsort_stats_t stats;
+        teamsort_get_stats(sorter, &stats);
+        
+        printf("Parallel sort results:\n");
+        printf("  Algorithm: %s%s\n", teamsort_engine_name(sort_algorithm),
+               sort_algorithm == TEAMSORT_BLOCK ? " (local sort + merge-split network)" : "");
         printf("  Total threads: %d (across %d teams)\n", NUM_TEAMS * threads_per_team, NUM_TEAMS);
-        printf("  Array size: %d elements (padded to %d)\n", array_size, padded_array_size);
+        printf("  Array size: %d elements (%s %d)\n", array_size,
+               pad_to_power_of_2 ? "padded to" : "network length", padded_array_size);
+        if (input_file) {
+            printf("  Input: %s, mapped in place\n", input_file);
+            printf("  File I/O: map %.6f s, fault-in %.6f s (slowest thread; %ld minor, %ld major faults), "
+                   "msync %.6f s\n", file_map_seconds, generate_ns_max / 1e9,
+                   faults_loaded[0] - faults_start[0], faults_loaded[1] - faults_start[1],
+                   file_sync_seconds);
+            printf("  Faults during sort: %ld minor, %ld major\n",
+                   faults_sorted[0] - faults_loaded[0], faults_sorted[1] - faults_loaded[1]);
+        } else {
+            printf("  Input: %s, seed %llu, generated in %.6f seconds (slowest thread)\n",
+                   input_dist_name(input_dist), input_seed, generate_ns_max / 1e9);
+        }
         printf("  Sort time: %.6f seconds\n", sort_time);
+        if (sort_algorithm == TEAMSORT_BITONIC) {
+            printf("  Kernels: %s\n", teamsort_kernels_name(sorter));
+        }
+        printf("  Barrier stages: %lld\n", stats.barrier_stages);
+        
+        // Time spent waiting, summed over all threads
+        int thread_count = NUM_TEAMS * threads_per_team;
+        char barrier_label[64];
+        if (barrier_kind == SORT_BARRIER_FUTEX) {
+            snprintf(barrier_label, sizeof(barrier_label), "futex, spin %ld", barrier_spin_limit);
+        } else {
+            snprintf(barrier_label, sizeof(barrier_label), "pthread");
+        }
+        printf("  Barrier (%s): %lld rounds, %.6f s total wait, "
+               "%.1f us avg per thread-round, %.1f us max, %lld futex sleeps\n",
+               barrier_label, stats.barrier_rounds, stats.barrier_wait_ns / 1e9,
+               stats.barrier_rounds > 0 ?
+                   stats.barrier_wait_ns / 1e3 / ((double)stats.barrier_rounds * thread_count) : 0.0,
+               stats.barrier_max_wait_ns / 1e3, stats.barrier_sleeps);
+        
+        if (sort_algorithm == TEAMSORT_BLOCK) {
+            printf("  Merge-split steps: %lld executed, %lld skipped (blocks already ordered)\n",
+                   stats.merge_splits, stats.merge_splits_skipped);
+        } else if (sort_algorithm == TEAMSORT_RADIX) {
+            printf("  Key range: [%d, %d]\n", stats.radix_key_min, stats.radix_key_max);
+            if (stats.radix_counting) {
+                printf("  Radix: %s, one pass over %lld values\n", stats.radix_mode,
+                       (long long)stats.radix_key_max - stats.radix_key_min + 1);
+            } else {
+                printf("  Radix: %s, %d passes of %d bits (%d skipped, digit same for all keys)\n",
+                       stats.radix_mode, stats.radix_passes,
+                       stats.radix_digit_bits, stats.radix_passes_skipped);
+            }
+        } else {
+            // Work and memory against the power-of-2 padded network
+            long long padded_work = bitonic_padded_work(array_size);
+            long long padded_bytes = (long long)next_power_of_2(array_size) * sizeof(int);
+            long long used_bytes = (long long)padded_array_size * sizeof(int);
+            printf("  Compare-exchanges: %lld (padded network: %lld, saved %.1f%%)\n",
+                   stats.compare_exchanges, padded_work,
+                   padded_work > 0 ? 100.0 * (padded_work - stats.compare_exchanges) / padded_work : 0.0);
+            printf("  Array memory: %lld bytes (padded network: %lld bytes, saved %.1f%%)\n",
+                   used_bytes, padded_bytes,
+                   100.0 * (padded_bytes - used_bytes) / padded_bytes);
+        }
         printf("  Elements per second: %.0f\n", array_size / sort_time);
         printf("  Parallel efficiency: All %d threads collaborated\n", NUM_TEAMS * threads_per_team);
     } else {
         printf("[ERROR] Sort did not complete successfully\n");
     }
+    if (perf_mode != PERF_OFF) {
+        print_perf_summary();
+    }
     
     // Restore default signal handlers
     printf("\n[CLEANUP] Restoring default signal handlers...\n");
@@ -522,15 +1601,33 @@ int main(int argc, char *argv[]) {
     pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
     
     // Cleanup
-    pthread_barrier_destroy(&global_barrier);
+    teamsort_destroy(sorter);
+    if (!service_endpoint && !external_mode) {
+        sort_barrier_destroy(&start_barrier);
+    }
     
     for (int i = 0; i < NUM_TEAMS; i++) {
         free(teams[i].threads);
     }
-    free(main_array);
+    team_placement_destroy(&placement);
+    input_gen_destroy(&input_gen);
+    free(bench_input);
+    if (input_file && !external_mode) {
+        mapped_file_close(&mapped_input);
+    } else {
+        free(main_array);
+    }
     
     printf("\n=== Completed ===\n");
     printf("Threads: %d, Elements: %d\n", NUM_TEAMS * threads_per_team, array_size);
     
+    // Scripts see a failed or unverified sort: the input file may already
+    // be partly overwritten
+    if (external_mode) {
+        return external_ok && external_stats.sorted && external_stats.keys_preserved ? 0 : 1;
+    }
+    if (!service_endpoint) {
+        return array_ok ? 0 : 1;
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include "radix_sort.h"
+
+#define RADIX_MAX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_MAX_BITS)
+#define RADIX_COUNTING_MAX_RANGE 65536   // Largest value range sorted by counting
+#define WC_LINE 16                       // Ints per write-combining line (64 bytes)
+
+int radix_sort_init(radix_sort_t *rs, sort_barrier_t *barrier, int num_threads) {
+    memset(rs, 0, sizeof(*rs));
+    rs->barrier = barrier;
+    rs->num_threads = num_threads;
+    rs->histogram_cells = (long long)num_threads * RADIX_BUCKETS;
+    rs->histograms = malloc(rs->histogram_cells * sizeof(int));
+    rs->offset_cells = RADIX_BUCKETS + 1;
+    rs->offsets = malloc(rs->offset_cells * sizeof(int));
+    rs->thread_min = malloc(num_threads * sizeof(int));
+    rs->thread_max = malloc(num_threads * sizeof(int));
+    if (!rs->histograms || !rs->offsets || !rs->thread_min || !rs->thread_max) {
+        radix_sort_destroy(rs);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void radix_sort_destroy(radix_sort_t *rs) {
+    free(rs->histograms);
+    free(rs->offsets);
+    free(rs->thread_min);
+    free(rs->thread_max);
+    rs->histograms = NULL;
+    rs->offsets = NULL;
+    rs->thread_min = NULL;
+    rs->thread_max = NULL;
+}
+
+// Barrier between phases; thread 0 counts the rounds of the current sort
+static void group_wait(radix_sort_t *rs, int thread_id) {
+    sort_barrier_wait(rs->barrier, thread_id);
+    if (thread_id == 0) {
+        rs->rounds++;
+    }
+}
+
+const char *radix_sort_mode_name(int mode) {
+    return mode == RADIX_COUNTING ? "counting sort" : "LSD radix sort";
+}
+
+// Counting needs one histogram row of `range` cells per thread and pays
+// for reading all of them, so it is only chosen while that stays below
+// the cost of two radix passes over the keys
+static int counting_fits(long long range, int n, int num_threads) {
+    return range <= RADIX_COUNTING_MAX_RANGE && range * num_threads <= 2LL * n;
+}
+
+// Thread 0 only, between the min/max and the plan barriers. Falls back to
+// radix passes if the counting tables cannot be grown.
+static void plan_sort(radix_sort_t *rs, int n) {
+    int key_min = INT_MAX;
+    int key_max = INT_MIN;
+    for (int t = 0; t < rs->num_threads; t++) {
+        if (rs->thread_min[t] < key_min) key_min = rs->thread_min[t];
+        if (rs->thread_max[t] > key_max) key_max = rs->thread_max[t];
+    }
+    rs->key_min = key_min;
+    rs->key_max = key_max;
+    rs->rounds = 1;     // The min/max barrier
+    rs->passes = 0;
+    rs->passes_skipped = 0;
+    rs->digit_bits = 0;
+    rs->mode = RADIX_LSD;
+    if (n < 2 || key_min >= key_max) return;
+
+    long long range = (long long)key_max - key_min + 1;
+    if (counting_fits(range, n, rs->num_threads)) {
+        long long cells = range * rs->num_threads;
+        int ok = 1;
+        if (cells > rs->histogram_cells) {
+            int *grown = realloc(rs->histograms, cells * sizeof(int));
+            if (grown) {
+                rs->histograms = grown;
+                rs->histogram_cells = cells;
+            } else {
+                ok = 0;
+            }
+        }
+        // Only ever grow: LSD passes keep using offsets for RADIX_BUCKETS totals
+        if (ok && range + 1 > rs->offset_cells) {
+            int *offsets = realloc(rs->offsets, (range + 1) * sizeof(int));
+            if (offsets) {
+                rs->offsets = offsets;
+                rs->offset_cells = range + 1;
+            } else {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            rs->mode = RADIX_COUNTING;
+            return;
+        }
+    }
+
+    // Split the significant bits evenly over the fewest passes of <= 8 bits
+    unsigned int span = (unsigned int)key_max - (unsigned int)key_min;
+    int bits = 32 - __builtin_clz(span);
+    int passes = (bits + RADIX_MAX_BITS - 1) / RADIX_MAX_BITS;
+    rs->digit_bits = (bits + passes - 1) / passes;
+    rs->passes = passes;
+}
+
+static void counting_sort(radix_sort_t *rs, int *arr, int n, int thread_id) {
+    int num_threads = rs->num_threads;
+    int range = rs->key_max - rs->key_min + 1;
+    unsigned int base = (unsigned int)rs->key_min;
+    int start = (int)((long long)n * thread_id / num_threads);
+    int end = (int)((long long)n * (thread_id + 1) / num_threads);
+
+    int *row = rs->histograms + (long long)thread_id * range;
+    memset(row, 0, range * sizeof(int));
+    for (int i = start; i < end; i++) {
+        row[(unsigned int)arr[i] - base]++;
+    }
+    group_wait(rs, thread_id);
+
+    // Column totals for this thread's share of the values, row by row so
+    // the histograms are read sequentially
+    int value_start = (int)((long long)range * thread_id / num_threads);
+    int value_end = (int)((long long)range * (thread_id + 1) / num_threads);
+    int *counts = rs->offsets;
+    memset(counts + value_start, 0, (value_end - value_start) * sizeof(int));
+    for (int t = 0; t < num_threads; t++) {
+        const int *other = rs->histograms + (long long)t * range;
+        for (int v = value_start; v < value_end; v++) {
+            counts[v] += other[v];
+        }
+    }
+    group_wait(rs, thread_id);
+
+    if (thread_id == 0) {
+        int sum = 0;
+        for (int v = 0; v < range; v++) {
+            int count = counts[v];
+            counts[v] = sum;
+            sum += count;
+        }
+        counts[range] = sum;
+    }
+    group_wait(rs, thread_id);
+
+    // Write output positions [start, end): find the value covering start,
+    // then emit runs of equal keys
+    int lo = 0, hi = range;
+    while (hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        if (counts[mid] <= start) lo = mid; else hi = mid;
+    }
+    int i = start;
+    for (int v = lo; i < end; v++) {
+        int run_end = counts[v + 1] < end ? counts[v + 1] : end;
+        int key = (int)(base + (unsigned int)v);
+        while (i < run_end) arr[i++] = key;
+    }
+    group_wait(rs, thread_id);
+}
+
+// One LSD pass: this thread's slice of src is scattered into dst. Returns
+// 0 if the pass was skipped because every key has the same digit.
+static int radix_pass(radix_sort_t *rs, const int *src, int *dst, int n, int shift, int thread_id) {
+    int num_threads = rs->num_threads;
+    int buckets = 1 << rs->digit_bits;
+    unsigned int mask = buckets - 1;
+    unsigned int base = (unsigned int)rs->key_min;
+    int start = (int)((long long)n * thread_id / num_threads);
+    int end = (int)((long long)n * (thread_id + 1) / num_threads);
+
+    int *row = rs->histograms + (long long)thread_id * RADIX_BUCKETS;
+    memset(row, 0, buckets * sizeof(int));
+    for (int i = start; i < end; i++) {
+        row[(((unsigned int)src[i] - base) >> shift) & mask]++;
+    }
+    group_wait(rs, thread_id);
+
+    // Exclusive prefix down each bucket column: row t then holds where
+    // thread t starts inside each bucket; offsets[] gets the bucket sizes
+    int *totals = rs->offsets;
+    for (int b = thread_id; b < buckets; b += num_threads) {
+        int running = 0;
+        for (int t = 0; t < num_threads; t++) {
+            int *cell = rs->histograms + (long long)t * RADIX_BUCKETS + b;
+            int count = *cell;
+            *cell = running;
+            running += count;
+        }
+        totals[b] = running;
+    }
+    group_wait(rs, thread_id);
+
+    int pos[RADIX_BUCKETS];
+    int sum = 0;
+    for (int b = 0; b < buckets; b++) {
+        if (totals[b] == n) return 0;
+        pos[b] = sum + row[b];
+        sum += totals[b];
+    }
+
+    // Stage keys per bucket and write them out a cache line at a time; a
+    // line is flushed when the bucket's write position reaches a line
+    // boundary, so full flushes land on aligned 64-byte blocks
+    int lines[RADIX_BUCKETS][WC_LINE] __attribute__((aligned(64)));
+    int fill[RADIX_BUCKETS];
+    memset(fill, 0, buckets * sizeof(int));
+    for (int i = start; i < end; i++) {
+        int key = src[i];
+        int b = (((unsigned int)key - base) >> shift) & mask;
+        int f = fill[b];
+        lines[b][f++] = key;
+        if (((pos[b] + f) & (WC_LINE - 1)) == 0) {
+            if (f == WC_LINE) {
+                memcpy(dst + pos[b], lines[b], WC_LINE * sizeof(int));
+            } else {
+                memcpy(dst + pos[b], lines[b], f * sizeof(int));
+            }
+            pos[b] += f;
+            f = 0;
+        }
+        fill[b] = f;
+    }
+    for (int b = 0; b < buckets; b++) {
+        if (fill[b] > 0) {
+            memcpy(dst + pos[b], lines[b], fill[b] * sizeof(int));
+        }
+    }
+    group_wait(rs, thread_id);
+    return 1;
+}
+
+void radix_sort(radix_sort_t *rs, int *arr, int *scratch, int n, int thread_id) {
+    int num_threads = rs->num_threads;
+    int start = (int)((long long)n * thread_id / num_threads);
+    int end = (int)((long long)n * (thread_id + 1) / num_threads);
+
+    int local_min = INT_MAX;
+    int local_max = INT_MIN;
+    for (int i = start; i < end; i++) {
+        if (arr[i] < local_min) local_min = arr[i];
+        if (arr[i] > local_max) local_max = arr[i];
+    }
+    rs->thread_min[thread_id] = local_min;
+    rs->thread_max[thread_id] = local_max;
+    group_wait(rs, thread_id);
+    if (thread_id == 0) {
+        plan_sort(rs, n);
+    }
+    group_wait(rs, thread_id);
+
+    if (rs->mode == RADIX_COUNTING) {
+        counting_sort(rs, arr, n, thread_id);
+        return;
+    }
+
+    int *src = arr;
+    int *dst = scratch;
+    for (int pass = 0; pass < rs->passes; pass++) {
+        if (radix_pass(rs, src, dst, n, pass * rs->digit_bits, thread_id)) {
+            int *swap = src;
+            src = dst;
+            dst = swap;
+        } else if (thread_id == 0) {
+            rs->passes_skipped++;
+        }
+    }
+
+    if (src != arr) {
+        memcpy(arr + start, src + start, (end - start) * sizeof(int));
+        group_wait(rs, thread_id);
+    }
+}
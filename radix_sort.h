@@ -0,0 +1,57 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include "sort_barrier.h"
+
+// Parallel integer sort shared by a group of threads.
+//
+// Every thread of the group calls radix_sort with its own thread_id; the
+// group's barrier separates the phases. The threads first find the key
+// range from per-thread min/max scans. Keys are then handled as
+// key - min, which keeps the order of the full signed 32-bit range:
+//
+//  - small ranges get one counting pass: per-thread histograms of the
+//    values, a prefix sum, and each thread writes its slice of the output
+//    straight from the counts (in place, no scratch);
+//  - anything else gets LSD radix passes of at most 8 bits. Each pass
+//    builds per-thread digit histograms, turns them into per-thread bucket
+//    offsets, and scatters through cache-line write-combining buffers into
+//    the other buffer. Passes whose digit is the same for every key are
+//    skipped.
+
+#define RADIX_COUNTING  0
+#define RADIX_LSD       1
+
+typedef struct {
+    sort_barrier_t *barrier;     // Barrier of the calling group
+    int num_threads;
+    int *histograms;             // num_threads rows of bucket or value counts
+    long long histogram_cells;
+    int *offsets;                // Counting mode: first output index per value
+    long long offset_cells;
+    int *thread_min;
+    int *thread_max;
+    // Shape of the last sort, written by thread 0
+    int mode;
+    int key_min;
+    int key_max;
+    int passes;
+    int passes_skipped;
+    int digit_bits;
+    long rounds;                 // Barrier rounds used
+} radix_sort_t;
+
+// Returns 0 on success, -1 with errno set on failure. barrier must have
+// num_threads participants and outlive the context.
+int radix_sort_init(radix_sort_t *rs, sort_barrier_t *barrier, int num_threads);
+
+// Sort arr[0..n) ascending. Called by all threads of the group with
+// thread_id in [0, num_threads). scratch must hold n ints; the result is
+// always left in arr.
+void radix_sort(radix_sort_t *rs, int *arr, int *scratch, int n, int thread_id);
+
+void radix_sort_destroy(radix_sort_t *rs);
+
+const char *radix_sort_mode_name(int mode);
+
+#endif
@@ -0,0 +1,211 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include "signal_dispatch.h"
+
+// One team's mailbox. The dispatcher writes head and the message slots;
+// the team leader writes tail and the delivery stats.
+typedef struct {
+    signal_message_t slots[SIGNAL_MAILBOX_SLOTS];
+    unsigned long head __attribute__((aligned(64)));
+    unsigned long tail __attribute__((aligned(64)));
+    long long delivered;
+    long long latency_ns_total;
+    long long latency_ns_max;
+} signal_mailbox_t;
+
+static signal_routes_t table;
+static signal_mailbox_t *mailboxes = NULL;
+static int signal_fd = -1;
+static int stop_fd = -1;
+static pthread_t dispatcher;
+
+// Dispatcher-only counters, read after the join
+static long long received = 0;
+static long long unrouted = 0;
+static long long posted = 0;
+static long long dropped = 0;
+
+static long long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+int signal_routes_init(signal_routes_t *routes, int num_teams) {
+    if (num_teams <= 0 || num_teams > SIGNAL_ROUTES_MAX_TEAMS) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(routes, 0, sizeof(*routes));
+    routes->num_teams = num_teams;
+    sigemptyset(&routes->handled);
+    for (int t = 0; t < num_teams; t++) {
+        sigemptyset(&routes->own[t]);
+        sigemptyset(&routes->others[t]);
+    }
+    return 0;
+}
+
+int signal_routes_add(signal_routes_t *routes, int team, int sig) {
+    if (team < 0 || team >= routes->num_teams || sig <= 0 || sig >= NSIG) {
+        errno = EINVAL;
+        return -1;
+    }
+    routes->owners[sig] |= 1u << team;
+    sigaddset(&routes->handled, sig);
+    sigaddset(&routes->own[team], sig);
+    for (int t = 0; t < routes->num_teams; t++) {
+        if (routes->owners[sig] & (1u << t)) {
+            sigdelset(&routes->others[t], sig);
+        } else {
+            sigaddset(&routes->others[t], sig);
+        }
+    }
+    return 0;
+}
+
+static void post(int team, const signal_message_t *msg) {
+    signal_mailbox_t *box = &mailboxes[team];
+    unsigned long head = box->head;
+    if (head - __atomic_load_n(&box->tail, __ATOMIC_ACQUIRE) >= SIGNAL_MAILBOX_SLOTS) {
+        dropped++;
+        return;
+    }
+    box->slots[head & (SIGNAL_MAILBOX_SLOTS - 1)] = *msg;
+    box->slots[head & (SIGNAL_MAILBOX_SLOTS - 1)].team = team;
+    __atomic_store_n(&box->head, head + 1, __ATOMIC_RELEASE);
+    posted++;
+}
+
+// Route everything the signalfd holds. Returns 0 once it is empty.
+static int route_pending(void) {
+    struct signalfd_siginfo info[16];
+    for (;;) {
+        ssize_t got = read(signal_fd, info, sizeof(info));
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN ? 0 : -1;
+        }
+        long long now = now_ns();
+        int count = got / sizeof(info[0]);
+        for (int i = 0; i < count; i++) {
+            received++;
+            unsigned int owners = info[i].ssi_signo < NSIG ? table.owners[info[i].ssi_signo] : 0;
+            if (!owners) {
+                unrouted++;
+                continue;
+            }
+            signal_message_t msg = {
+                (int)info[i].ssi_signo, -1, (pid_t)info[i].ssi_pid, info[i].ssi_code,
+                (long long)info[i].ssi_ptr, now
+            };
+            for (int t = 0; t < table.num_teams; t++) {
+                if (owners & (1u << t)) {
+                    post(t, &msg);
+                }
+            }
+        }
+    }
+}
+
+static void *dispatcher_main(void *arg) {
+    (void)arg;
+    struct pollfd fds[2] = {{signal_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (route_pending() != 0) break;
+        if (fds[1].revents & POLLIN) break;
+    }
+    // Whatever arrived up to the stop request still reaches the mailboxes
+    route_pending();
+    return NULL;
+}
+
+int signal_dispatch_start(const signal_routes_t *routes) {
+    table = *routes;
+    void *memory;
+    int result = posix_memalign(&memory, 64, table.num_teams * sizeof(signal_mailbox_t));
+    if (result != 0) {
+        errno = result;
+        return -1;
+    }
+    memset(memory, 0, table.num_teams * sizeof(signal_mailbox_t));
+    mailboxes = memory;
+    received = unrouted = posted = dropped = 0;
+
+    signal_fd = signalfd(-1, &table.handled, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0) goto fail;
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd < 0) goto fail;
+    result = pthread_create(&dispatcher, NULL, dispatcher_main, NULL);
+    if (result != 0) {
+        errno = result;
+        goto fail;
+    }
+    return 0;
+
+fail:;
+    int saved = errno;
+    if (signal_fd >= 0) close(signal_fd);
+    if (stop_fd >= 0) close(stop_fd);
+    signal_fd = stop_fd = -1;
+    free(mailboxes);
+    mailboxes = NULL;
+    errno = saved;
+    return -1;
+}
+
+int signal_dispatch_poll(int team, signal_message_t *msg) {
+    signal_mailbox_t *box = &mailboxes[team];
+    unsigned long tail = box->tail;
+    if (tail == __atomic_load_n(&box->head, __ATOMIC_ACQUIRE)) return 0;
+
+    *msg = box->slots[tail & (SIGNAL_MAILBOX_SLOTS - 1)];
+    __atomic_store_n(&box->tail, tail + 1, __ATOMIC_RELEASE);
+
+    long long latency = now_ns() - msg->received_ns;
+    __atomic_store_n(&box->delivered, box->delivered + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&box->latency_ns_total, box->latency_ns_total + latency, __ATOMIC_RELAXED);
+    if (latency > box->latency_ns_max) {
+        __atomic_store_n(&box->latency_ns_max, latency, __ATOMIC_RELAXED);
+    }
+    return 1;
+}
+
+void signal_dispatch_stop(signal_dispatch_stats_t *stats) {
+    unsigned long long one = 1;
+    if (write(stop_fd, &one, sizeof(one)) != sizeof(one)) {
+        // The dispatcher would never wake up; closing is not enough for poll
+        pthread_cancel(dispatcher);
+    }
+    pthread_join(dispatcher, NULL);
+    close(signal_fd);
+    close(stop_fd);
+    signal_fd = stop_fd = -1;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->received = received;
+    stats->unrouted = unrouted;
+    stats->posted = posted;
+    stats->dropped = dropped;
+    for (int t = 0; t < table.num_teams; t++) {
+        signal_mailbox_t *box = &mailboxes[t];
+        stats->delivered += __atomic_load_n(&box->delivered, __ATOMIC_RELAXED);
+        stats->pending += __atomic_load_n(&box->head, __ATOMIC_ACQUIRE) -
+                          __atomic_load_n(&box->tail, __ATOMIC_ACQUIRE);
+        stats->latency_ns_total += __atomic_load_n(&box->latency_ns_total, __ATOMIC_RELAXED);
+        long long max = __atomic_load_n(&box->latency_ns_max, __ATOMIC_RELAXED);
+        if (max > stats->latency_ns_max) stats->latency_ns_max = max;
+    }
+    // Mailboxes stay allocated: a team leader may still poll on its way out
+}
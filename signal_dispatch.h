@@ -0,0 +1,73 @@
+#ifndef SIGNAL_DISPATCH_H
+#define SIGNAL_DISPATCH_H
+
+#include <signal.h>
+#include <sys/types.h>
+
+// Signal routing table and optional dispatcher thread.
+//
+// signal_routes_t maps every signal to the bitmask of teams that own it,
+// and keeps each team's thread mask ready-made, so a thread sets up its
+// mask with two pthread_sigmask calls and a signal finds its teams with
+// one table lookup.
+//
+// Dispatcher mode takes signal delivery off the sort threads entirely:
+// every thread keeps all signals blocked and one dispatcher thread reads
+// them from a signalfd. Each signal is posted to a lock-free mailbox of
+// every team that owns it (single producer, the dispatcher; single
+// consumer, the team's leader thread), and the teams take their messages
+// at stage boundaries with signal_dispatch_poll. A sort thread is then
+// never interrupted in the middle of a stage; a full mailbox drops the
+// message and counts it.
+
+#define SIGNAL_ROUTES_MAX_TEAMS 32
+#define SIGNAL_MAILBOX_SLOTS 64         // Messages per team, power of 2
+
+typedef struct {
+    int num_teams;
+    unsigned int owners[NSIG];          // Bit t: team t owns the signal
+    sigset_t handled;                   // Owned by at least one team
+    sigset_t own[SIGNAL_ROUTES_MAX_TEAMS];
+    sigset_t others[SIGNAL_ROUTES_MAX_TEAMS];   // Owned by other teams only
+} signal_routes_t;
+
+typedef struct {
+    int sig;
+    int team;
+    pid_t sender;               // si_pid
+    int code;                   // si_code: SI_USER for kill, SI_QUEUE for sigqueue
+    long long value;            // sigqueue payload
+    long long received_ns;      // CLOCK_MONOTONIC when the dispatcher read it
+} signal_message_t;
+
+typedef struct {
+    long long received;         // Read from the signalfd
+    long long unrouted;         // No team owns the signal
+    long long posted;           // Messages, one per owning team
+    long long dropped;          // Mailbox full
+    long long delivered;        // Taken by the teams
+    long long pending;          // Still in a mailbox at stop
+    long long latency_ns_total; // Read by the dispatcher until taken
+    long long latency_ns_max;
+} signal_dispatch_stats_t;
+
+// Empty table for num_teams teams. Returns 0, or -1 with errno EINVAL.
+int signal_routes_init(signal_routes_t *routes, int num_teams);
+
+// Give sig to team. Returns 0, or -1 with errno EINVAL.
+int signal_routes_add(signal_routes_t *routes, int team, int sig);
+
+// Start the dispatcher for every handled signal of routes (copied). Call
+// with all of them blocked in every thread; the dispatcher inherits the
+// caller's mask. Returns 0, or -1 with errno set.
+int signal_dispatch_start(const signal_routes_t *routes);
+
+// Take the oldest message of team's mailbox into msg. Returns 1 if there
+// was one, 0 if not. Only one thread per team may poll.
+int signal_dispatch_poll(int team, signal_message_t *msg);
+
+// Stop the dispatcher after routing what is still queued in the signalfd,
+// and fill in stats. Messages nobody took count as pending.
+void signal_dispatch_stop(signal_dispatch_stats_t *stats);
+
+#endif
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include "signal_load.h"
+
+#define SEQ_MASK ((1u << SIGNAL_LOAD_SEQ_BITS) - 1)
+#define TIME_MASK ((1LL << SIGNAL_LOAD_TIME_BITS) - 1)
+
+long long signal_load_tag(unsigned int seq, long long send_ns) {
+    return (long long)(seq & SEQ_MASK) << SIGNAL_LOAD_TIME_BITS | (send_ns & TIME_MASK);
+}
+
+// Values below 16 get a bucket each; above, 8 buckets per power of 2
+static int bucket_of(long long ns) {
+    if (ns < 16) return (int)ns;
+    int exponent = 63 - __builtin_clzll((unsigned long long)ns);
+    int bucket = 16 + (exponent - 4) * 8 + (int)((ns >> (exponent - 3)) & 7);
+    return bucket < SIGNAL_LOAD_BUCKETS ? bucket : SIGNAL_LOAD_BUCKETS - 1;
+}
+
+static long long bucket_limit(int bucket) {
+    if (bucket < 16) return bucket;
+    int exponent = (bucket - 16) / 8 + 4;
+    long long sub = (bucket - 16) % 8;
+    return ((8 + sub + 1) << (exponent - 3)) - 1;
+}
+
+void signal_load_init(signal_load_t *load) {
+    memset(load, 0, sizeof(*load));
+}
+
+// Stream slot of a sender, claimed on first sight; -1 if all are taken
+static int sender_slot(signal_load_t *load, int sender) {
+    for (int i = 0; i < SIGNAL_LOAD_SENDERS; i++) {
+        if (load->senders[i] == sender) return i;
+        if (load->senders[i] == 0) {
+            load->senders[i] = sender;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void signal_load_add(signal_load_t *load, int sig, int sender, int code, long long value,
+                     long long receive_ns) {
+    if (sig <= 0 || sig >= NSIG) return;
+    signal_load_signal_t *stats = &load->signals[sig];
+    if (code != SI_QUEUE) {
+        stats->untagged++;
+        return;
+    }
+
+    long long latency = (receive_ns - value) & TIME_MASK;
+    stats->tagged++;
+    stats->latency_ns_total += latency;
+    if (latency > stats->latency_ns_max) stats->latency_ns_max = latency;
+    stats->histogram[bucket_of(latency)]++;
+
+    int slot = sender_slot(load, sender);
+    if (slot < 0) {
+        load->unknown_sender++;
+        return;
+    }
+    // Senders number each stream from 0
+    unsigned int seq = (unsigned int)((unsigned long long)value >> SIGNAL_LOAD_TIME_BITS) & SEQ_MASK;
+    unsigned int expected = load->started[slot][sig] ? load->next_seq[slot][sig] : 0;
+    unsigned int gap = (seq - expected) & SEQ_MASK;
+    if (gap < (1u << (SIGNAL_LOAD_SEQ_BITS - 1))) {
+        stats->missing += gap;
+        load->next_seq[slot][sig] = (seq + 1) & SEQ_MASK;
+        load->started[slot][sig] = 1;
+    } else {
+        stats->repeated++;
+    }
+}
+
+long long signal_load_percentile(const signal_load_t *load, int sig, double p) {
+    const signal_load_signal_t *stats = &load->signals[sig];
+    if (stats->tagged == 0) return 0;
+    long long rank = (long long)(p / 100.0 * stats->tagged + 0.5);
+    if (rank < 1) rank = 1;
+    long long seen = 0;
+    for (int b = 0; b < SIGNAL_LOAD_BUCKETS; b++) {
+        seen += stats->histogram[b];
+        if (seen >= rank) {
+            long long limit = bucket_limit(b);
+            return limit < stats->latency_ns_max ? limit : stats->latency_ns_max;
+        }
+    }
+    return stats->latency_ns_max;
+}
+
+void signal_load_print(const signal_load_t *load) {
+    int header = 0;
+    for (int sig = 1; sig < NSIG; sig++) {
+        const signal_load_signal_t *stats = &load->signals[sig];
+        if (stats->tagged == 0 && stats->untagged == 0) continue;
+        if (!header) {
+            printf("Signal delivery (sigqueue tags: send to delivery latency):\n");
+            header = 1;
+        }
+        printf("  %2d %-24s", sig, strsignal(sig));
+        if (stats->tagged > 0) {
+            printf(" %lld tagged, latency avg %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us; "
+                   "%lld missing (coalesced), %lld repeated",
+                   stats->tagged, stats->latency_ns_total / 1e3 / stats->tagged,
+                   signal_load_percentile(load, sig, 50) / 1e3,
+                   signal_load_percentile(load, sig, 99) / 1e3,
+                   stats->latency_ns_max / 1e3, stats->missing, stats->repeated);
+            if (stats->untagged > 0) printf(";");
+        }
+        if (stats->untagged > 0) {
+            printf(" %lld untagged", stats->untagged);
+        }
+        printf("\n");
+    }
+    if (load->unknown_sender > 0) {
+        printf("  %lld tagged signals from more than %d senders not checked for gaps\n",
+               load->unknown_sender, SIGNAL_LOAD_SENDERS);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef SIGNAL_LOAD_H
+#define SIGNAL_LOAD_H
+
+// Tagged signal traffic: the sender side of signal_tester's load mode and
+// the receiver side statistics of both sort programs.
+//
+// signal_tester sends with sigqueue and puts a tag into si_value: a 24-bit
+// sequence number, counted per (target, signal), and the low 40 bits of
+// CLOCK_MONOTONIC at the send (wraps every ~18 minutes; latency is taken
+// modulo that). CLOCK_MONOTONIC is system-wide, so the receiver gets the
+// delivery latency by subtracting the tag from its own timestamp.
+//
+// The receiver keeps a log-linear latency histogram per signal (8 buckets
+// per power of 2, so a percentile is within 12.5%) and one sequence stream
+// per (sender, signal). A jump in the sequence counts the skipped numbers
+// as missing: standard signals sent while one of the same kind is pending
+// are coalesced by the kernel. A number below the stream's next expected
+// one is a repeat: a signal owned by two teams that the dispatcher handed
+// to both, or a late one. Signals not sent with sigqueue are only counted.
+
+#include <signal.h>
+
+#define SIGNAL_LOAD_SEQ_BITS 24
+#define SIGNAL_LOAD_TIME_BITS 40
+#define SIGNAL_LOAD_SENDERS 16          // Sequence streams are kept per sender
+#define SIGNAL_LOAD_BUCKETS 304         // Latencies up to 2^40 ns
+
+typedef struct {
+    long long tagged;
+    long long untagged;
+    long long missing;
+    long long repeated;
+    long long latency_ns_total;
+    long long latency_ns_max;
+    long long histogram[SIGNAL_LOAD_BUCKETS];
+} signal_load_signal_t;
+
+typedef struct {
+    signal_load_signal_t signals[NSIG];
+    int senders[SIGNAL_LOAD_SENDERS];               // pid, 0 for a free slot
+    unsigned int next_seq[SIGNAL_LOAD_SENDERS][NSIG];
+    unsigned char started[SIGNAL_LOAD_SENDERS][NSIG];
+    long long unknown_sender;                       // Tagged, but no stream slot left
+} signal_load_t;
+
+// Tag for the seq-th signal of a stream, sent at send_ns (CLOCK_MONOTONIC)
+long long signal_load_tag(unsigned int seq, long long send_ns);
+
+void signal_load_init(signal_load_t *load);
+
+// One delivered signal: code and value as in its siginfo, receive_ns on
+// CLOCK_MONOTONIC. Not thread-safe; both programs call it from the signal
+// log's logger thread.
+void signal_load_add(signal_load_t *load, int sig, int sender, int code, long long value,
+                     long long receive_ns);
+
+// Latency at percentile p (0-100) of sig's tagged signals, upper edge of
+// the bucket; 0 if there were none
+long long signal_load_percentile(const signal_load_t *load, int sig, double p);
+
+// Per-signal latency, missing and repeat counts. Prints nothing if no
+// signal arrived.
+void signal_load_print(const signal_load_t *load);
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "signal_log.h"
+
+// One thread's ring. The owning thread's handler is the only producer and
+// writes head and the stats; the logger is the only consumer and writes tail.
+typedef struct {
+    signal_event_t events[SIGNAL_LOG_RING];
+    unsigned long head __attribute__((aligned(64)));
+    unsigned long tail __attribute__((aligned(64)));
+    int team;
+    int thread;
+    long long dropped;
+    long long handler_ns_total;
+    long long handler_ns_max;
+} signal_ring_t;
+
+static signal_ring_t *rings = NULL;
+static int ring_count = 0;
+static int rings_used = 0;
+static long long recorded = 0;
+static long long unregistered = 0;
+static long long wall_offset_ns = 0;    // CLOCK_REALTIME - CLOCK_MONOTONIC
+
+static pthread_t logger;
+static int logger_stop = 0;
+static signal_report_fn report_fn = NULL;
+static signal_event_t *drained = NULL;
+
+// Initial-exec TLS in the executable, so reading it from a handler never
+// allocates
+static __thread signal_ring_t *my_ring = NULL;
+
+static long long now_ns(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+void signal_log_record(int sig, int sender, int code, long long value) {
+    int saved_errno = errno;
+    long long start = now_ns(CLOCK_MONOTONIC);
+    __atomic_add_fetch(&recorded, 1, __ATOMIC_RELAXED);
+
+    signal_ring_t *ring = my_ring;
+    if (!ring) {
+        __atomic_add_fetch(&unregistered, 1, __ATOMIC_RELAXED);
+        errno = saved_errno;
+        return;
+    }
+    unsigned long head = ring->head;
+    unsigned long tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= SIGNAL_LOG_RING) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        errno = saved_errno;
+        return;
+    }
+
+    signal_event_t *event = &ring->events[head & (SIGNAL_LOG_RING - 1)];
+    event->sig = sig;
+    event->team = ring->team;
+    event->thread = ring->thread;
+    event->time_ns = start;
+    event->sender = sender;
+    event->code = code;
+    event->value = value;
+    long long elapsed = now_ns(CLOCK_MONOTONIC) - start;
+    event->handler_ns = elapsed;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&ring->handler_ns_total, ring->handler_ns_total + elapsed, __ATOMIC_RELAXED);
+    if (elapsed > ring->handler_ns_max) {
+        __atomic_store_n(&ring->handler_ns_max, elapsed, __ATOMIC_RELAXED);
+    }
+    errno = saved_errno;
+}
+
+long long signal_log_count(void) {
+    return __atomic_load_n(&recorded, __ATOMIC_RELAXED);
+}
+
+static int compare_events(const void *a, const void *b) {
+    long long x = ((const signal_event_t *)a)->time_ns;
+    long long y = ((const signal_event_t *)b)->time_ns;
+    return (x > y) - (x < y);
+}
+
+// Take everything the rings hold and report it in time order
+static void drain_rings(void) {
+    int used = __atomic_load_n(&rings_used, __ATOMIC_ACQUIRE);
+    if (used > ring_count) used = ring_count;
+    int count = 0;
+    for (int r = 0; r < used; r++) {
+        signal_ring_t *ring = &rings[r];
+        unsigned long tail = ring->tail;
+        unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        while (tail != head) {
+            drained[count++] = ring->events[tail & (SIGNAL_LOG_RING - 1)];
+            tail++;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+    qsort(drained, count, sizeof(signal_event_t), compare_events);
+    for (int i = 0; i < count; i++) {
+        report_fn(&drained[i]);
+    }
+}
+
+static void *logger_main(void *arg) {
+    (void)arg;
+    struct timespec poll = {0, SIGNAL_LOG_POLL_NS};
+    for (;;) {
+        int stopping = __atomic_load_n(&logger_stop, __ATOMIC_ACQUIRE);
+        drain_rings();
+        if (stopping) break;
+        nanosleep(&poll, NULL);
+    }
+    return NULL;
+}
+
+int signal_log_start(int max_threads, signal_report_fn report) {
+    void *memory;
+    int result = posix_memalign(&memory, 64, max_threads * sizeof(signal_ring_t));
+    if (result != 0) {
+        errno = result;
+        return -1;
+    }
+    drained = malloc((size_t)max_threads * SIGNAL_LOG_RING * sizeof(signal_event_t));
+    if (!drained) {
+        free(memory);
+        errno = ENOMEM;
+        return -1;
+    }
+    memset(memory, 0, max_threads * sizeof(signal_ring_t));
+    rings = memory;
+    ring_count = max_threads;
+    rings_used = 0;
+    report_fn = report;
+    logger_stop = 0;
+    wall_offset_ns = now_ns(CLOCK_REALTIME) - now_ns(CLOCK_MONOTONIC);
+
+    result = pthread_create(&logger, NULL, logger_main, NULL);
+    if (result != 0) {
+        free(rings);
+        free(drained);
+        rings = NULL;
+        drained = NULL;
+        errno = result;
+        return -1;
+    }
+    return 0;
+}
+
+int signal_log_register(int team, int thread) {
+    int index = __atomic_fetch_add(&rings_used, 1, __ATOMIC_ACQ_REL);
+    if (index >= ring_count) return -1;
+    rings[index].team = team;
+    rings[index].thread = thread;
+    my_ring = &rings[index];
+    return 0;
+}
+
+void signal_log_timestamp(long long time_ns, char *buf, size_t len) {
+    long long wall = time_ns + wall_offset_ns;
+    time_t seconds = wall / 1000000000LL;
+    struct tm tm_info;
+    localtime_r(&seconds, &tm_info);
+    size_t used = strftime(buf, len, "%Y-%m-%d %H:%M:%S", &tm_info);
+    snprintf(buf + used, len - used, ".%03lld", wall / 1000000 % 1000);
+}
+
+void signal_log_stop(signal_log_stats_t *stats) {
+    __atomic_store_n(&logger_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(logger, NULL);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->events = signal_log_count();
+    stats->unregistered = __atomic_load_n(&unregistered, __ATOMIC_RELAXED);
+    int used = rings_used < ring_count ? rings_used : ring_count;
+    for (int r = 0; r < used; r++) {
+        stats->dropped += __atomic_load_n(&rings[r].dropped, __ATOMIC_RELAXED);
+        stats->handler_ns_total += __atomic_load_n(&rings[r].handler_ns_total, __ATOMIC_RELAXED);
+        long long max = __atomic_load_n(&rings[r].handler_ns_max, __ATOMIC_RELAXED);
+        if (max > stats->handler_ns_max) stats->handler_ns_max = max;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef SIGNAL_LOG_H
+#define SIGNAL_LOG_H
+
+#include <stddef.h>
+
+// Async-signal-safe signal event log.
+//
+// Each thread that may take signals registers once and gets its own
+// single-producer/single-consumer ring, found through thread-local storage.
+// The signal handler only calls signal_log_record: one CLOCK_MONOTONIC read,
+// one slot write and a release store of the ring head. No locks, stdio,
+// allocation or scans over the thread tables. Handlers on one thread do not
+// nest as long as the handled signals are blocked during the handler
+// (sa_mask), so each ring has exactly one producer.
+//
+// A background logger thread drains all rings every SIGNAL_LOG_POLL_NS,
+// orders the drained events by timestamp and passes them to the program's
+// report function, which does the formatting and printing. A full ring
+// drops the event and counts it.
+
+#define SIGNAL_LOG_RING 256             // Events per thread, power of 2
+#define SIGNAL_LOG_POLL_NS 1000000L     // Logger drain interval
+
+typedef struct {
+    int sig;
+    int team;               // -1 for threads outside the teams
+    int thread;
+    long long time_ns;      // CLOCK_MONOTONIC at handler entry
+    long long handler_ns;   // Handler entry until the event was stored
+    int sender;             // si_pid
+    int code;               // si_code, SI_QUEUE for sigqueue
+    long long value;        // si_value of a sigqueue (see signal_load.h)
+} signal_event_t;
+
+// Called on the logger thread for every event, in timestamp order per drain
+typedef void (*signal_report_fn)(const signal_event_t *event);
+
+typedef struct {
+    long long events;
+    long long dropped;          // Ring full
+    long long unregistered;     // Taken by a thread without a ring
+    long long handler_ns_total;
+    long long handler_ns_max;
+} signal_log_stats_t;
+
+// Allocate rings for up to max_threads threads and start the logger. Call
+// from a thread with the handled signals blocked (the logger inherits its
+// mask). Returns 0, or -1 with errno set.
+int signal_log_start(int max_threads, signal_report_fn report);
+
+// Give the calling thread a ring; team and thread are stored in its events.
+// Returns 0, or -1 if every ring is taken.
+int signal_log_register(int team, int thread);
+
+// Record sig for the calling thread, with the sender, si_code and si_value
+// of its siginfo. Async-signal-safe.
+void signal_log_record(int sig, int sender, int code, long long value);
+
+// Events recorded so far (including dropped ones). Async-signal-safe.
+long long signal_log_count(void);
+
+// Format a time_ns as local wall-clock time with milliseconds
+void signal_log_timestamp(long long time_ns, char *buf, size_t len);
+
+// Drain the rings a last time, stop the logger and fill in stats. The
+// rings stay allocated, so a late signal on a registered thread is still
+// recorded safely (and never reported).
+void signal_log_stop(signal_log_stats_t *stats);
+
+#endif
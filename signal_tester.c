@@ -1,51 +1,310 @@
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
-#include <sys/types.h> 
+#include <sys/types.h>
 #include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#include <getopt.h>
+#include "signal_load.h"
+
+// Load mode: every target gets the same signal sequence. Each tick sends
+// `burst` signals to every target back to back; ticks are spaced so the
+// average rate per target is `rate` (0: no pause at all). Signals go out
+// with sigqueue, tagged with a sequence number per (target, signal) and
+// the send time (signal_load.h), so the target can measure latency and
+// count coalesced signals.
+
+#define MAX_TARGETS 64
+#define MAX_MIX 32
+
+typedef struct {
+    pid_t pid;
+    int alive;
+    unsigned int seq[NSIG];
+    long long sent[NSIG];
+    long long failed;       // EAGAIN: the target's queued signal limit
+} target_t;
+
+target_t targets[MAX_TARGETS];
+int num_targets = 0;
+int mix_signals[MAX_MIX];
+int mix_weights[MAX_MIX];
+int mix_count = 0;
+int mix_total = 0;
+
+// Function declarations
+void print_usage(const char *prog);
+int parse_mix(const char *list);
+int mix_pick(long long index);
+long long now_ns(void);
+int run_load(double rate, long long count, double duration, int burst, int use_kill);
+
+void print_usage(const char *prog) {
+    printf("Usage: %s <pid> <signal_number>\n", prog);
+    printf("       %s [options] <pid>... [signal_number]\n", prog);
+    printf("\nWith only a pid and a signal, one kill() is sent. Any option switches to\n");
+    printf("load mode: signals are sent with sigqueue, tagged with a sequence number and\n");
+    printf("the send time, to every pid.\n");
+    printf("\nOptions:\n");
+    printf("  --mix=LIST     Signals to send, e.g. 2,1,6 or 2:3,1:1 (weight after the colon);\n");
+    printf("                 default: the signal_number argument\n");
+    printf("  --rate=N       Signals per second to each target (default 0: as fast as possible)\n");
+    printf("  --count=N      Signals to each target (default 1000)\n");
+    printf("  --duration=S   Send for S seconds instead of a fixed count\n");
+    printf("  --burst=N      Signals sent back to back per tick (default 1); the average rate\n");
+    printf("                 stays --rate\n");
+    printf("  --kill         Plain kill() instead of sigqueue (no tags)\n");
+    printf("  -h, --help     Show this help\n");
+    printf("\nSignals:\n");
+    printf("  %d - SIGINT\n", SIGINT);
+    printf("  %d - SIGABRT\n", SIGABRT);
+    printf("  %d - SIGILL\n", SIGILL);
+    printf("  %d - SIGCHLD\n", SIGCHLD);
+    printf("  %d - SIGSEGV\n", SIGSEGV);
+    printf("  %d - SIGFPE\n", SIGFPE);
+    printf("  %d - SIGHUP\n", SIGHUP);
+    printf("  %d - SIGTSTP\n", SIGTSTP);
+    printf("\nExample: %s 1234 2\n", prog);
+    printf("         %s --rate=10000 --duration=5 --mix=2,1,6 1234 5678\n", prog);
+}
+
+// "2,1:3,6" -> signals with weights (default 1). Returns 0, or -1.
+int parse_mix(const char *list) {
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long sig = strtol(p, &end, 10);
+        long weight = 1;
+        if (end == p || sig < 1 || sig >= NSIG) return -1;
+        p = end;
+        if (*p == ':') {
+            weight = strtol(p + 1, &end, 10);
+            if (end == p + 1 || weight < 1 || weight > 1000) return -1;
+            p = end;
+        }
+        if (mix_count == MAX_MIX) return -1;
+        mix_signals[mix_count] = (int)sig;
+        mix_weights[mix_count] = (int)weight;
+        mix_total += (int)weight;
+        mix_count++;
+        if (*p == ',') p++;
+        else if (*p) return -1;
+    }
+    return mix_count > 0 ? 0 : -1;
+}
+
+// Weighted round robin: signal number index of the sequence
+int mix_pick(long long index) {
+    int slot = (int)(index % mix_total);
+    for (int i = 0; i < mix_count; i++) {
+        if (slot < mix_weights[i]) return mix_signals[i];
+        slot -= mix_weights[i];
+    }
+    return mix_signals[0];
+}
+
+long long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+int run_load(double rate, long long count, double duration, int burst, int use_kill) {
+    long long tick_ns = rate > 0 ? (long long)(burst * 1e9 / rate) : 0;
+    long long start = now_ns();
+    long long stop_at = duration > 0 ? start + (long long)(duration * 1e9) : 0;
+    long long next_tick = start;
+    long long index = 0;
+    long long late_ticks = 0;
+    int alive = num_targets;
+
+    printf("Sending to %d target%s: %s, ", num_targets, num_targets == 1 ? "" : "s",
+           use_kill ? "kill()" : "sigqueue with tags");
+    if (rate > 0) printf("%.0f signals/sec each", rate);
+    else printf("no rate limit");
+    printf(" in bursts of %d, ", burst);
+    if (duration > 0) printf("for %.1f s\n", duration);
+    else printf("%lld signals each\n", count);
+    fflush(stdout);
+
+    while (alive > 0) {
+        if (stop_at ? now_ns() >= stop_at : index >= count) break;
+
+        for (int b = 0; b < burst && (stop_at || index < count); b++, index++) {
+            int sig = mix_pick(index);
+            for (int t = 0; t < num_targets; t++) {
+                target_t *target = &targets[t];
+                if (!target->alive) continue;
+                int result;
+                if (use_kill) {
+                    result = kill(target->pid, sig);
+                } else {
+                    union sigval value;
+                    value.sival_ptr = (void *)(intptr_t)signal_load_tag(target->seq[sig], now_ns());
+                    result = sigqueue(target->pid, sig, value);
+                }
+                if (result == 0) {
+                    target->seq[sig]++;
+                    target->sent[sig]++;
+                } else if (errno == EAGAIN) {
+                    target->failed++;
+                } else {
+                    printf("Target %d: %s, no longer sending to it\n", target->pid, strerror(errno));
+                    target->alive = 0;
+                    alive--;
+                }
+            }
+        }
+
+        if (tick_ns > 0) {
+            next_tick += tick_ns;
+            long long now = now_ns();
+            if (next_tick > now) {
+                struct timespec until = {next_tick / 1000000000LL, next_tick % 1000000000LL};
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+                }
+            } else {
+                late_ticks++;
+            }
+        }
+    }
+
+    double elapsed = (now_ns() - start) / 1e9;
+    long long total = 0;
+    for (int t = 0; t < num_targets; t++) {
+        target_t *target = &targets[t];
+        long long sent = 0;
+        printf("Target %d:", target->pid);
+        for (int sig = 1; sig < NSIG; sig++) {
+            if (target->sent[sig] > 0) {
+                printf(" %s %lld,", strsignal(sig), target->sent[sig]);
+                sent += target->sent[sig];
+            }
+        }
+        printf(" total %lld sent (%.0f/sec), %lld refused (queue full)\n",
+               sent, elapsed > 0 ? sent / elapsed : 0.0, target->failed);
+        total += sent;
+    }
+    printf("Sent %lld signals in %.3f s", total, elapsed);
+    if (tick_ns > 0) {
+        printf(", %lld of %lld ticks late", late_ticks, index / burst);
+    }
+    printf("\n");
+    return alive == num_targets ? 0 : 1;
+}
 
 int main(int argc, char *argv[]) {
     printf("Signal Tester - ECE 434 Project 1\n");
-    
-    if (argc != 3) {
-        printf("Usage: %s <pid> <signal_number>\n", argv[0]);
-        printf("\nSignals:\n");
-        printf("  %d - SIGINT\n", SIGINT);
-        printf("  %d - SIGABRT\n", SIGABRT);
-        printf("  %d - SIGILL\n", SIGILL);
-        printf("  %d - SIGCHLD\n", SIGCHLD);
-        printf("  %d - SIGSEGV\n", SIGSEGV);
-        printf("  %d - SIGFPE\n", SIGFPE);
-        printf("  %d - SIGHUP\n", SIGHUP);
-        printf("  %d - SIGTSTP\n", SIGTSTP);
-        printf("\nExample: %s 1234 2\n", argv[0]);
-        return 1;
+
+    static struct option long_options[] = {
+        {"mix",      required_argument, NULL, 'm'},
+        {"rate",     required_argument, NULL, 'r'},
+        {"count",    required_argument, NULL, 'c'},
+        {"duration", required_argument, NULL, 'd'},
+        {"burst",    required_argument, NULL, 'b'},
+        {"kill",     no_argument, NULL, 'k'},
+        {"help",     no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    double rate = 0, duration = 0;
+    long long count = 1000;
+    int burst = 1, use_kill = 0, load_mode = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        load_mode = 1;
+        switch (opt) {
+        case 'm':
+            if (parse_mix(optarg) != 0) {
+                printf("Error: Invalid signal mix '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            rate = atof(optarg);
+            if (rate < 0) {
+                printf("Error: Invalid rate %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            count = atoll(optarg);
+            if (count <= 0) {
+                printf("Error: Invalid count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'd':
+            duration = atof(optarg);
+            if (duration <= 0) {
+                printf("Error: Invalid duration %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'b':
+            burst = atoi(optarg);
+            if (burst <= 0) {
+                printf("Error: Invalid burst %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'k':
+            use_kill = 1;
+            break;
+        case 'h':
+        default:
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
     }
-    
-    pid_t target_pid = atoi(argv[1]);
-    int signal_num = atoi(argv[2]);
-    
-    if (target_pid <= 0) {
-        printf("Error: Invalid PID %d\n", target_pid);
+
+    // Without --mix the last argument is the signal
+    int positional = argc - optind;
+    if (mix_count == 0) positional--;
+    if (positional < 1 || positional > MAX_TARGETS) {
+        print_usage(argv[0]);
         return 1;
     }
-    
-    if (signal_num < 1 || signal_num > 31) {
-        printf("Error: Invalid signal %d (must be 1-31)\n", signal_num);
-        return 1;
+    for (int i = 0; i < positional; i++) {
+        pid_t target_pid = atoi(argv[optind + i]);
+        if (target_pid <= 0) {
+            printf("Error: Invalid PID %d\n", target_pid);
+            return 1;
+        }
+        targets[num_targets].pid = target_pid;
+        targets[num_targets].alive = 1;
+        num_targets++;
     }
-    
-    printf("Sending signal %d to process %d\n", signal_num, target_pid);
-    
-    if (kill(target_pid, signal_num) == -1) {
-        perror("Failed to send signal");
-        return 1;
+
+    if (mix_count == 0) {
+        int signal_num = atoi(argv[argc - 1]);
+        if (signal_num < 1 || signal_num > 31) {
+            printf("Error: Invalid signal %d (must be 1-31)\n", signal_num);
+            return 1;
+        }
+        mix_signals[0] = signal_num;
+        mix_weights[0] = 1;
+        mix_count = mix_total = 1;
+    }
+
+    if (load_mode) {
+        return run_load(rate, count, duration, burst, use_kill);
     }
-    
+
+    int signal_num = mix_signals[0];
+    for (int t = 0; t < num_targets; t++) {
+        printf("Sending signal %d to process %d\n", signal_num, targets[t].pid);
+
+        if (kill(targets[t].pid, signal_num) == -1) {
+            perror("Failed to send signal");
+            return 1;
+        }
+    }
+
     printf("Signal sent successfully\n");
     return 0;
-}
\ No newline at end of file
+}
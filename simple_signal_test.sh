@@ -7,7 +7,8 @@ echo ""
 
 # Compile the signal testing version
 echo "🔨 Building signal testing version..."
-gcc -Wall -Wextra -std=c99 -pthread -D_GNU_SOURCE -o project1_signals project1_signals.c -lrt
+# project1_signals links other objects of the tree; the Makefile rule lists them
+make project1_signals
 
 if [ $? -ne 0 ]; then
     echo "❌ Build failed!"
@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "sort_barrier.h"
+
+#define DEFAULT_SPIN_LIMIT 4000
+#define OVERSUBSCRIBED_SPIN_LIMIT 50
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void futex_wait(int *addr, int expected) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake_all(int *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int sort_barrier_init(sort_barrier_t *barrier, int kind, int num_threads, long spin_limit) {
+    if (num_threads <= 0 || spin_limit < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    barrier->kind = kind;
+    barrier->num_threads = num_threads;
+    barrier->spin_limit = spin_limit;
+    barrier->arrived = 0;
+    barrier->sense = 0;
+    barrier->sleepers = 0;
+
+    barrier->stats = calloc(num_threads, sizeof(sort_barrier_stats_t));
+    if (!barrier->stats) return -1;
+
+    if (kind == SORT_BARRIER_PTHREAD) {
+        int result = pthread_barrier_init(&barrier->pthread_barrier, NULL, num_threads);
+        if (result != 0) {
+            free(barrier->stats);
+            errno = result;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Release the round: reset the arrival count before flipping the sense so a
+// thread racing ahead into the next round always sees a clean count
+static int futex_barrier_wait(sort_barrier_t *barrier, sort_barrier_stats_t *stats) {
+    int sense = __atomic_load_n(&barrier->sense, __ATOMIC_ACQUIRE);
+
+    if (__atomic_add_fetch(&barrier->arrived, 1, __ATOMIC_ACQ_REL) == barrier->num_threads) {
+        __atomic_store_n(&barrier->arrived, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&barrier->sense, sense + 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&barrier->sleepers, __ATOMIC_SEQ_CST) > 0) {
+            futex_wake_all(&barrier->sense);
+        }
+        return 1;
+    }
+
+    for (long spin = 0; spin < barrier->spin_limit; spin++) {
+        if (__atomic_load_n(&barrier->sense, __ATOMIC_ACQUIRE) != sense) {
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    // Announce the sleeper before re-checking the sense; FUTEX_WAIT returns
+    // at once if the sense already moved, so a late wakeup cannot be lost
+    __atomic_add_fetch(&barrier->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&barrier->sense, __ATOMIC_SEQ_CST) == sense) {
+        futex_wait(&barrier->sense, sense);
+        stats->sleeps++;
+    }
+    __atomic_sub_fetch(&barrier->sleepers, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int sort_barrier_wait(sort_barrier_t *barrier, int thread_id) {
+    sort_barrier_stats_t *stats = &barrier->stats[thread_id];
+    long long start = now_ns();
+
+    int serial;
+    if (barrier->kind == SORT_BARRIER_PTHREAD) {
+        serial = (pthread_barrier_wait(&barrier->pthread_barrier) == PTHREAD_BARRIER_SERIAL_THREAD);
+    } else {
+        serial = futex_barrier_wait(barrier, stats);
+    }
+
+    long long waited = now_ns() - start;
+    stats->waits++;
+    stats->wait_ns += waited;
+    if (waited > stats->max_wait_ns) stats->max_wait_ns = waited;
+    return serial;
+}
+
+void sort_barrier_reset_stats(sort_barrier_t *barrier, int thread_id) {
+    sort_barrier_stats_t *stats = &barrier->stats[thread_id];
+    stats->waits = 0;
+    stats->wait_ns = 0;
+    stats->max_wait_ns = 0;
+    stats->sleeps = 0;
+}
+
+void sort_barrier_summary(const sort_barrier_t *barrier, sort_barrier_summary_t *summary) {
+    summary->rounds = 0;
+    summary->total_wait_ns = 0;
+    summary->max_wait_ns = 0;
+    summary->sleeps = 0;
+    for (int i = 0; i < barrier->num_threads; i++) {
+        const sort_barrier_stats_t *stats = &barrier->stats[i];
+        if (stats->waits > summary->rounds) summary->rounds = stats->waits;
+        summary->total_wait_ns += stats->wait_ns;
+        summary->sleeps += stats->sleeps;
+        if (stats->max_wait_ns > summary->max_wait_ns) summary->max_wait_ns = stats->max_wait_ns;
+    }
+}
+
+void sort_barrier_destroy(sort_barrier_t *barrier) {
+    if (barrier->kind == SORT_BARRIER_PTHREAD) {
+        pthread_barrier_destroy(&barrier->pthread_barrier);
+    }
+    free(barrier->stats);
+    barrier->stats = NULL;
+}
+
+long sort_barrier_default_spin(int num_threads) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0 && num_threads > cpus) {
+        return OVERSUBSCRIBED_SPIN_LIMIT;
+    }
+    return DEFAULT_SPIN_LIMIT;
+}
+
+const char *sort_barrier_kind_name(int kind) {
+    return kind == SORT_BARRIER_PTHREAD ? "pthread" : "futex";
+}
@@ -0,0 +1,67 @@
+#ifndef SORT_BARRIER_H
+#define SORT_BARRIER_H
+
+#include <pthread.h>
+
+// Barrier for the sort threads.
+//
+// SORT_BARRIER_FUTEX is a centralized sense-reversing barrier: the last
+// thread to arrive resets the count and flips the shared sense word (a
+// generation counter whose change releases the round). Waiters spin on the
+// sense word for a bounded number of iterations and then sleep on it with
+// FUTEX_WAIT, so short stages never enter the kernel and long ones do not
+// burn CPU. SORT_BARRIER_PTHREAD wraps pthread_barrier_t with the same
+// accounting so the two can be compared directly.
+
+#define SORT_BARRIER_FUTEX   0
+#define SORT_BARRIER_PTHREAD 1
+
+// Per-thread wait accounting, padded to a cache line
+typedef struct {
+    long long waits;
+    long long wait_ns;
+    long long max_wait_ns;
+    long long sleeps;
+    char pad[64 - 4 * sizeof(long long)];
+} sort_barrier_stats_t;
+
+typedef struct {
+    int kind;
+    int num_threads;
+    long spin_limit;
+    // Futex barrier state, each word on its own cache line
+    int arrived __attribute__((aligned(64)));
+    int sense __attribute__((aligned(64)));
+    int sleepers __attribute__((aligned(64)));
+    pthread_barrier_t pthread_barrier;
+    sort_barrier_stats_t *stats;
+} sort_barrier_t;
+
+// Totals over all threads, filled by sort_barrier_summary
+typedef struct {
+    long long rounds;
+    long long total_wait_ns;
+    long long max_wait_ns;
+    long long sleeps;
+} sort_barrier_summary_t;
+
+// Returns 0 on success, -1 with errno set on failure
+int sort_barrier_init(sort_barrier_t *barrier, int kind, int num_threads, long spin_limit);
+
+// Waits for all num_threads threads. thread_id selects the stats slot.
+// Returns 1 in exactly one thread per round, 0 in the others.
+int sort_barrier_wait(sort_barrier_t *barrier, int thread_id);
+
+// Clears one thread's stats slot, e.g. after a start-up barrier
+void sort_barrier_reset_stats(sort_barrier_t *barrier, int thread_id);
+
+void sort_barrier_summary(const sort_barrier_t *barrier, sort_barrier_summary_t *summary);
+void sort_barrier_destroy(sort_barrier_t *barrier);
+
+// Spin budget suited to this machine: spinning only pays off when every
+// sort thread has a CPU of its own
+long sort_barrier_default_spin(int num_threads);
+
+const char *sort_barrier_kind_name(int kind);
+
+#endif
@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "sort_service.h"
+
+#define MAX_CLIENTS 64
+
+// Per-connection framing state
+typedef struct {
+    int in_fd;
+    int out_fd;
+    int open;
+    unsigned int generation; // Tells this connection from earlier ones in the slot
+    int reading;             // Cleared at end of input; responses still go out
+    unsigned char header[4];
+    int header_bytes;        // Header bytes received for the current frame
+    sort_job_t job;          // Job being received once the header is complete
+    long payload_bytes;      // Payload bytes received so far
+} service_client_t;
+
+static const char *service_endpoint = NULL;
+static int listen_fd = -1;
+static int stdin_mode = 0;
+static int stdin_response_fd = -1;
+static service_client_t clients[MAX_CLIENTS];
+static int num_clients = 0;
+static unsigned int next_generation = 0;
+static int shutdown_requested = 0;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int add_client(int in_fd, int out_fd) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (!clients[i].open) {
+            memset(&clients[i], 0, sizeof(clients[i]));
+            clients[i].in_fd = in_fd;
+            clients[i].out_fd = out_fd;
+            clients[i].open = 1;
+            clients[i].generation = ++next_generation;
+            clients[i].reading = 1;
+            if (i >= num_clients) num_clients = i + 1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// End of input: drop any partial frame but keep the connection open until
+// the responses for its completed jobs have been written
+static void end_client_input(int index) {
+    service_client_t *client = &clients[index];
+    free(client->job.data);
+    client->job.data = NULL;
+    client->header_bytes = 0;
+    client->reading = 0;
+    if (stdin_mode) shutdown_requested = 1;
+}
+
+static void close_client(int index) {
+    service_client_t *client = &clients[index];
+    if (!client->open) return;
+    if (client->reading) end_client_input(index);
+    if (!stdin_mode) close(client->in_fd);
+    client->open = 0;
+}
+
+int sort_service_open(const char *endpoint) {
+    service_endpoint = endpoint;
+    memset(clients, 0, sizeof(clients));
+
+    if (strcmp(endpoint, "stdin") == 0) {
+        stdin_mode = 1;
+        stdin_response_fd = dup(STDOUT_FILENO);
+        if (stdin_response_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            fprintf(stderr, "[ERROR] Failed to redirect stdout for service mode: %s\n", strerror(errno));
+            return -1;
+        }
+        add_client(STDIN_FILENO, stdin_response_fd);
+        return 0;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(endpoint) >= sizeof(addr.sun_path)) {
+        printf("[ERROR] Socket path too long: %s\n", endpoint);
+        return -1;
+    }
+    strcpy(addr.sun_path, endpoint);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        printf("[ERROR] Failed to create socket: %s\n", strerror(errno));
+        return -1;
+    }
+    unlink(endpoint);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, MAX_CLIENTS) < 0) {
+        printf("[ERROR] Failed to listen on %s: %s\n", endpoint, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t written = stdin_mode ? write(fd, p, len) : send(fd, p, len, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += written;
+        len -= written;
+    }
+    return 0;
+}
+
+// Reads what is available on one connection. Returns a finished job
+// through *done (1) or 0 if the frame is still incomplete.
+static int read_client(int index, sort_job_t *done) {
+    service_client_t *client = &clients[index];
+    ssize_t got;
+
+    if (client->header_bytes < 4) {
+        got = read(client->in_fd, client->header + client->header_bytes, 4 - client->header_bytes);
+        if (got <= 0) {
+            if (got < 0 && errno == EINTR) return 0;
+            end_client_input(index);
+            return 0;
+        }
+        client->header_bytes += got;
+        if (client->header_bytes < 4) return 0;
+
+        unsigned int count;
+        memcpy(&count, client->header, 4);
+        if (count == SORT_SERVICE_SHUTDOWN) {
+            shutdown_requested = 1;
+            client->header_bytes = 0;
+            return 0;
+        }
+        if (count > SORT_SERVICE_MAX_JOB) {
+            printf("[SERVICE] Client %d: job of %u elements exceeds limit, closing\n", index, count);
+            close_client(index);
+            return 0;
+        }
+        client->job.n = (int)count;
+        client->job.client = index;
+        client->job.generation = client->generation;
+        client->job.data = malloc(((size_t)count + 1) * sizeof(int));
+        client->payload_bytes = 0;
+        if (!client->job.data) {
+            printf("[SERVICE] Client %d: out of memory for %u elements\n", index, count);
+            close_client(index);
+            return 0;
+        }
+    } else {
+        long want = (long)client->job.n * (long)sizeof(int) - client->payload_bytes;
+        got = read(client->in_fd, (char *)client->job.data + client->payload_bytes, want);
+        if (got <= 0) {
+            if (got < 0 && errno == EINTR) return 0;
+            end_client_input(index);
+            return 0;
+        }
+        client->payload_bytes += got;
+    }
+
+    if (client->payload_bytes == (long)client->job.n * (long)sizeof(int)) {
+        client->job.received_ns = now_ns();
+        *done = client->job;
+        client->job.data = NULL;
+        client->header_bytes = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static int compare_long_long(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+int sort_service_run(sort_batch_fn run_batch, int max_batch_jobs, sort_service_stats_t *stats) {
+    sort_job_t *batch = malloc(max_batch_jobs * sizeof(sort_job_t));
+    long long latency_capacity = 1024, latency_count = 0;
+    long long *latencies = malloc(latency_capacity * sizeof(long long));
+    struct pollfd fds[MAX_CLIENTS + 1];
+    int fd_client[MAX_CLIENTS + 1];
+    long long first_request_ns = 0, last_response_ns = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!batch || !latencies) {
+        free(batch);
+        free(latencies);
+        return -1;
+    }
+
+    printf("[SERVICE] Listening on %s (batches of up to %d jobs)\n", service_endpoint, max_batch_jobs);
+    fflush(stdout);
+
+    while (!shutdown_requested) {
+        int batch_size = 0;
+
+        // Gather: block for the first event, then drain everything already
+        // readable without waiting so concurrent small jobs share a batch
+        int timeout = -1;
+        for (;;) {
+            int nfds = 0;
+            if (listen_fd >= 0) {
+                fds[nfds].fd = listen_fd;
+                fds[nfds].events = POLLIN;
+                fd_client[nfds++] = -1;
+            }
+            for (int i = 0; i < num_clients; i++) {
+                if (!clients[i].open || !clients[i].reading) continue;
+                fds[nfds].fd = clients[i].in_fd;
+                fds[nfds].events = POLLIN;
+                fd_client[nfds++] = i;
+            }
+            if (nfds == 0) break;
+
+            int ready = poll(fds, nfds, timeout);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) break;
+
+            for (int f = 0; f < nfds && batch_size < max_batch_jobs; f++) {
+                if (!(fds[f].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                if (fd_client[f] < 0) {
+                    int fd = accept(listen_fd, NULL, NULL);
+                    if (fd >= 0 && add_client(fd, fd) < 0) {
+                        printf("[SERVICE] Too many clients, rejecting connection\n");
+                        close(fd);
+                    }
+                    continue;
+                }
+                if (read_client(fd_client[f], &batch[batch_size])) {
+                    if (first_request_ns == 0) first_request_ns = batch[batch_size].received_ns;
+                    batch_size++;
+                }
+            }
+            if (batch_size >= max_batch_jobs || shutdown_requested) break;
+            timeout = 0;
+        }
+
+        if (batch_size == 0) continue;
+
+        run_batch(batch, batch_size);
+        stats->batches++;
+
+        for (int b = 0; b < batch_size; b++) {
+            sort_job_t *job = &batch[b];
+            service_client_t *client = &clients[job->client];
+            unsigned int count = (unsigned int)job->n;
+            // A client that went away during the gather may have handed its
+            // slot to a new connection: its results are dropped
+            if (client->open && client->generation == job->generation) {
+                if (write_all(client->out_fd, &count, 4) < 0 ||
+                    write_all(client->out_fd, job->data, (size_t)job->n * sizeof(int)) < 0) {
+                    close_client(job->client);
+                }
+            }
+            last_response_ns = now_ns();
+
+            if (latency_count == latency_capacity) {
+                latency_capacity *= 2;
+                long long *grown = realloc(latencies, latency_capacity * sizeof(long long));
+                if (grown) latencies = grown;
+                else latency_capacity /= 2;
+            }
+            if (latency_count < latency_capacity) {
+                latencies[latency_count++] = last_response_ns - job->received_ns;
+            }
+            stats->jobs++;
+            stats->elements += job->n;
+            free(job->data);
+        }
+        
+        // Connections whose input ended have had all their responses now
+        for (int i = 0; i < num_clients; i++) {
+            if (clients[i].open && !clients[i].reading) close_client(i);
+        }
+    }
+
+    for (int i = 0; i < num_clients; i++) {
+        close_client(i);
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(service_endpoint);
+        listen_fd = -1;
+    }
+
+    if (latency_count > 0) {
+        qsort(latencies, latency_count, sizeof(long long), compare_long_long);
+        long long total = 0;
+        for (long long i = 0; i < latency_count; i++) total += latencies[i];
+        stats->latency_avg_us = total / 1e3 / latency_count;
+        stats->latency_p50_us = latencies[latency_count / 2] / 1e3;
+        stats->latency_p99_us = latencies[(latency_count * 99) / 100] / 1e3;
+        stats->latency_max_us = latencies[latency_count - 1] / 1e3;
+        stats->busy_seconds = (last_response_ns - first_request_ns) / 1e9;
+    }
+
+    free(latencies);
+    free(batch);
+    return 0;
+}
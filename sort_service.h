@@ -0,0 +1,51 @@
+#ifndef SORT_SERVICE_H
+#define SORT_SERVICE_H
+
+// Long-running sort service front end.
+//
+// Jobs arrive either on stdin (responses on the original stdout) or over a
+// Unix-domain stream socket. Framing is the same both ways, in host byte
+// order:
+//
+//   request:  uint32 count, then count int32 keys
+//   response: uint32 count, then count int32 keys in ascending order
+//
+// A request with count == SORT_SERVICE_SHUTDOWN stops the service; so does
+// end of input in stdin mode. Every job that is complete when the front end
+// polls is collected into one batch and handed to the sort pool together.
+
+#define SORT_SERVICE_SHUTDOWN 0xFFFFFFFFu
+#define SORT_SERVICE_MAX_JOB 10000000
+
+typedef struct {
+    int *data;
+    int n;
+    int client;               // Index of the connection that sent the job
+    long long received_ns;    // When the last byte of the job arrived
+    unsigned int generation;  // Of that connection: a closed client's slot is reused
+} sort_job_t;
+
+// Sorts every job of the batch in place and returns when all are done
+typedef void (*sort_batch_fn)(sort_job_t *jobs, int num_jobs);
+
+typedef struct {
+    long long jobs;
+    long long elements;
+    long long batches;
+    double busy_seconds;      // First request received to last response sent
+    double latency_avg_us;
+    double latency_p50_us;
+    double latency_p99_us;
+    double latency_max_us;
+} sort_service_stats_t;
+
+// Set up the endpoint: "stdin" or a socket path. Call this before the
+// sort threads start. In stdin mode the original stdout is kept for
+// responses and stdout is pointed at stderr, so log lines printed from
+// here on cannot corrupt the response stream. Returns -1 on failure.
+int sort_service_open(const char *endpoint);
+
+// Serve until shutdown; returns 0 on a clean shutdown
+int sort_service_run(sort_batch_fn run_batch, int max_batch_jobs, sort_service_stats_t *stats);
+
+#endif
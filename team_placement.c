@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "team_placement.h"
+
+typedef struct {
+    int cpu;
+    int node;
+    int package;
+    int core;
+} cpu_info_t;
+
+int team_placement_parse(const char *name) {
+    if (strcmp(name, "none") == 0) return PLACEMENT_NONE;
+    if (strcmp(name, "cores") == 0) return PLACEMENT_CORES;
+    if (strcmp(name, "numa") == 0) return PLACEMENT_NUMA;
+    return -1;
+}
+
+const char *team_placement_mode_name(int mode) {
+    switch (mode) {
+    case PLACEMENT_CORES: return "cores";
+    case PLACEMENT_NUMA:  return "numa";
+    default:              return "none";
+    }
+}
+
+static int read_int_file(const char *path, int fallback) {
+    FILE *file = fopen(path, "r");
+    if (!file) return fallback;
+    int value;
+    if (fscanf(file, "%d", &value) != 1) value = fallback;
+    fclose(file);
+    return value;
+}
+
+// Parse a sysfs CPU list such as "0-3,8-11" into set; -1 if unreadable
+static int read_cpulist(const char *path, cpu_set_t *set) {
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+    char text[4096];
+    if (!fgets(text, sizeof(text), file)) text[0] = '\0';
+    fclose(file);
+
+    CPU_ZERO(set);
+    char *cursor = text;
+    while (*cursor && *cursor != '\n') {
+        char *end;
+        long first = strtol(cursor, &end, 10);
+        if (end == cursor) break;
+        long last = first;
+        if (*end == '-') {
+            cursor = end + 1;
+            last = strtol(cursor, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        cursor = (*end == ',') ? end + 1 : end;
+    }
+    return 0;
+}
+
+// Node, then package, then core: hyperthread siblings end up adjacent, so
+// contiguous slices of the order are whole cores on one node
+static int compare_cpus(const void *a, const void *b) {
+    const cpu_info_t *x = a, *y = b;
+    if (x->node != y->node) return x->node - y->node;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+static void format_cpulist(const cpu_set_t *set, char *text, size_t size) {
+    size_t used = 0;
+    text[0] = '\0';
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, set)) continue;
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) last++;
+        int written = (last > cpu)
+            ? snprintf(text + used, size - used, "%s%d-%d", used ? "," : "", cpu, last)
+            : snprintf(text + used, size - used, "%s%d", used ? "," : "", cpu);
+        if (written < 0 || (size_t)written >= size - used) break;
+        used += written;
+        cpu = last;
+    }
+}
+
+int team_placement_init(team_placement_t *placement, int mode, int num_teams) {
+    memset(placement, 0, sizeof(*placement));
+    placement->mode = mode;
+    placement->num_teams = num_teams;
+    if (mode == PLACEMENT_NONE) return 0;
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+
+    placement->team_cpus = calloc(num_teams, sizeof(cpu_set_t));
+    placement->team_node = calloc(num_teams, sizeof(int));
+    cpu_info_t *cpus = calloc(CPU_SETSIZE, sizeof(cpu_info_t));
+    if (!placement->team_cpus || !placement->team_node || !cpus) {
+        free(cpus);
+        team_placement_destroy(placement);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    int num_cpus = 0;
+    char path[128];
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        cpus[num_cpus].cpu = cpu;
+        cpus[num_cpus].node = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        cpus[num_cpus].package = read_int_file(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        cpus[num_cpus].core = read_int_file(path, cpu);
+        num_cpus++;
+    }
+
+    // Without a node directory (no NUMA support) everything is node 0
+    cpu_set_t online_nodes, node_cpus;
+    int node_list[CPU_SETSIZE];
+    int num_nodes = 0;
+    if (read_cpulist("/sys/devices/system/node/online", &online_nodes) == 0) {
+        for (int node = 0; node < CPU_SETSIZE; node++) {
+            if (!CPU_ISSET(node, &online_nodes)) continue;
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            if (read_cpulist(path, &node_cpus) != 0) continue;
+            int used = 0;
+            for (int i = 0; i < num_cpus; i++) {
+                if (CPU_ISSET(cpus[i].cpu, &node_cpus)) {
+                    cpus[i].node = node;
+                    used = 1;
+                }
+            }
+            if (used) node_list[num_nodes++] = node;
+        }
+    }
+    if (num_nodes == 0) node_list[num_nodes++] = 0;
+    qsort(cpus, num_cpus, sizeof(cpu_info_t), compare_cpus);
+
+    for (int team = 0; team < num_teams; team++) {
+        cpu_set_t *set = &placement->team_cpus[team];
+        CPU_ZERO(set);
+        if (mode == PLACEMENT_NUMA) {
+            int node = node_list[team % num_nodes];
+            for (int i = 0; i < num_cpus; i++) {
+                if (cpus[i].node == node) CPU_SET(cpus[i].cpu, set);
+            }
+            placement->team_node[team] = node;
+        } else {
+            // Fewer CPUs than teams: teams share CPUs round robin
+            int first = num_cpus >= num_teams ? (int)((long)num_cpus * team / num_teams) : team % num_cpus;
+            int last = num_cpus >= num_teams ? (int)((long)num_cpus * (team + 1) / num_teams) : first + 1;
+            placement->team_node[team] = cpus[first].node;
+            for (int i = first; i < last; i++) {
+                CPU_SET(cpus[i].cpu, set);
+                if (cpus[i].node != cpus[first].node) placement->team_node[team] = -1;
+            }
+        }
+    }
+
+    placement->num_nodes = num_nodes;
+    placement->num_cpus = num_cpus;
+    free(cpus);
+    return 0;
+}
+
+int team_placement_apply(const team_placement_t *placement, int team, pthread_attr_t *attr) {
+    if (placement->mode == PLACEMENT_NONE) return 0;
+    return pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &placement->team_cpus[team]);
+}
+
+void team_placement_print(const team_placement_t *placement) {
+    if (placement->mode == PLACEMENT_NONE) {
+        printf("[PLACEMENT] none: threads float over all CPUs\n");
+        return;
+    }
+    printf("[PLACEMENT] %s: %d teams over %d CPUs on %d NUMA node%s\n",
+           team_placement_mode_name(placement->mode), placement->num_teams,
+           placement->num_cpus, placement->num_nodes, placement->num_nodes == 1 ? "" : "s");
+    for (int team = 0; team < placement->num_teams; team++) {
+        char cpus[256];
+        format_cpulist(&placement->team_cpus[team], cpus, sizeof(cpus));
+        if (placement->team_node[team] >= 0) {
+            printf("[PLACEMENT] Team %d: CPUs %s (node %d)\n", team, cpus, placement->team_node[team]);
+        } else {
+            printf("[PLACEMENT] Team %d: CPUs %s (spans nodes)\n", team, cpus);
+        }
+    }
+}
+
+void team_placement_destroy(team_placement_t *placement) {
+    free(placement->team_cpus);
+    free(placement->team_node);
+    placement->team_cpus = NULL;
+    placement->team_node = NULL;
+}
@@ -0,0 +1,47 @@
+#ifndef TEAM_PLACEMENT_H
+#define TEAM_PLACEMENT_H
+
+#include <pthread.h>
+#include <sched.h>
+
+// CPU placement of the sort teams.
+//
+// The topology comes from sysfs: NUMA nodes from
+// /sys/devices/system/node/node*/cpulist, cores from each CPU's
+// topology/{physical_package_id,core_id}. Only CPUs in the process's
+// affinity mask are used. A team's threads are created with its CPU set
+// in their attributes, so they run there from their first instruction and
+// the pages they touch first are allocated on the team's node.
+
+#define PLACEMENT_NONE  0   // Default attributes, the scheduler decides
+#define PLACEMENT_CORES 1   // Allowed CPUs split into one contiguous core set per team
+#define PLACEMENT_NUMA  2   // Each team bound to one NUMA node, round robin over nodes
+
+typedef struct {
+    int mode;
+    int num_teams;
+    int num_nodes;          // Nodes with at least one allowed CPU
+    int num_cpus;           // Allowed CPUs
+    cpu_set_t *team_cpus;   // [team]
+    int *team_node;         // [team]: node of the set, -1 if it spans nodes
+} team_placement_t;
+
+// Returns the mode for "none", "cores" or "numa", or -1
+int team_placement_parse(const char *name);
+
+const char *team_placement_mode_name(int mode);
+
+// Read the topology and build the team mapping. Returns 0 on success, -1
+// with errno set on failure. With PLACEMENT_NONE nothing is read.
+int team_placement_init(team_placement_t *placement, int mode, int num_teams);
+
+// Set a team's CPU set on attr (no-op for PLACEMENT_NONE). Returns 0 or
+// an error number from pthread_attr_setaffinity_np.
+int team_placement_apply(const team_placement_t *placement, int team, pthread_attr_t *attr);
+
+// One "[PLACEMENT]" line per team with its CPUs and node
+void team_placement_print(const team_placement_t *placement);
+
+void team_placement_destroy(team_placement_t *placement);
+
+#endif
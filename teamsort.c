@@ -0,0 +1,575 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "teamsort.h"
+#include "bitonic_kernels.h"
+#include "sort_barrier.h"
+#include "radix_sort.h"
+
+#define INSERTION_SORT_CUTOFF 16
+
+// Engines of one context
+//
+// Bitonic: non-recursive network over any n elements. The outer loop walks
+// the merge size k, the inner loop the compare distance j; every (k, j)
+// stage holds independent compare-exchange pairs split into contiguous
+// ranges across the threads, so the sort needs one barrier per stage. The
+// first stage of each merge compares mirrored positions, so all pairs sort
+// ascending and pairs reaching past n are skipped (no padding needed).
+//
+// Block: each thread owns one contiguous block of ceil(n / num_threads)
+// elements, sorts it sequentially, and the same network runs over the
+// blocks with merge-splits as comparators. Results go to the opposite
+// buffer, so one barrier per stage is enough. block_in_scratch[s & 1]
+// holds where each block lives for stage s, so partners never read a flag
+// that is being rewritten.
+//
+// Radix: radix_sort.c on the context's stage barrier.
+struct teamsort {
+    int num_threads;
+    int engine;
+    long small_job;
+    const bitonic_kernels_t *kernels;
+    void (*stage_hook)(void *arg, int thread_id);
+    void *stage_arg;
+    void (*phase_hook)(void *arg, int thread_id, int phase);
+    void *phase_arg;
+    sort_barrier_t barrier;          // Stage barrier, num_threads
+    sort_barrier_t dispatch;         // Workers plus the submitting thread
+    radix_sort_t radix;
+    int radix_ready;
+    unsigned char *block_in_scratch[2];
+    void *scratch;
+    size_t scratch_bytes;
+    int scratch_fresh;               // Not yet touched by the workers
+    // Current batch
+    const teamsort_job_t *jobs;
+    int num_jobs;
+    int next_small;
+    int stop;
+    // Library-owned workers (teamsort_start), held at pool_ready until
+    // all of them exist: pool_state 1 runs them, -1 sends them home
+    pthread_t *pool;
+    struct pool_arg *pool_args;
+    pthread_mutex_t pool_lock;
+    pthread_cond_t pool_ready;
+    int pool_state;
+    // Stats; counters are updated by thread 0 or atomically
+    long long batches;
+    long long jobs_done;
+    long long elements;
+    long long barrier_stages;
+    long long compare_exchanges;
+    long long merge_splits;
+    long long merge_splits_skipped;
+    int radix_ran;
+    radix_sort_t radix_last;
+    double last_batch_seconds;
+};
+
+static const char *engine_names[] = {
+    "Parallel Bitonic Sort", "Block-Bitonic Hybrid", "Parallel Radix Sort"
+};
+
+static const size_t element_sizes[] = {
+    sizeof(int32_t), sizeof(int64_t), sizeof(uint64_t),
+    sizeof(float), sizeof(double), sizeof(teamsort_kv_t)
+};
+
+static int next_power_of_2(int n) {
+    int power = 1;
+    while (power < n) {
+        power *= 2;
+    }
+    return power;
+}
+
+// Called by every thread between stages and jobs
+static void stage_boundary(teamsort_t *ts, int thread_id) {
+    if (ts->stage_hook) {
+        ts->stage_hook(ts->stage_arg, thread_id);
+    }
+}
+
+static void enter_phase(teamsort_t *ts, int thread_id, int phase) {
+    if (ts->phase_hook) {
+        ts->phase_hook(ts->phase_arg, thread_id, phase);
+    }
+}
+
+// Phase of the merges of size k (a power of 2)
+static int merge_phase(int k) {
+    return TEAMSORT_PHASE_MERGE + 31 - __builtin_clz((unsigned int)k);
+}
+
+#define TS_TYPE int
+#define TS_SUFFIX int32
+#define TS_LESS(a, b) ((a) < (b))
+#define TS_STAGE bitonic_stage
+#include "teamsort_template.h"
+
+#define TS_TYPE int64_t
+#define TS_SUFFIX int64
+#define TS_LESS(a, b) ((a) < (b))
+#include "teamsort_template.h"
+
+#define TS_TYPE uint64_t
+#define TS_SUFFIX uint64
+#define TS_LESS(a, b) ((a) < (b))
+#include "teamsort_template.h"
+
+#define TS_TYPE teamsort_kv_t
+#define TS_SUFFIX kv
+#define TS_LESS(a, b) ((a).key < (b).key)
+#include "teamsort_template.h"
+
+// IEEE 754 totalOrder as signed integer order: negative values (sign bit
+// set) have their magnitude bits inverted, so larger magnitudes compare
+// lower; non-negative values already order like integers. The map is its
+// own inverse. Floats and doubles are sorted in place as these integers.
+static void float_to_ordered(int32_t *bits, long first, long last) {
+    for (long i = first; i < last; i++) {
+        bits[i] ^= (bits[i] >> 31) & 0x7FFFFFFF;
+    }
+}
+
+static void double_to_ordered(int64_t *bits, long first, long last) {
+    for (long i = first; i < last; i++) {
+        bits[i] ^= (bits[i] >> 63) & 0x7FFFFFFFFFFFFFFFLL;
+    }
+}
+
+static int radix_type(int type) {
+    return type == TEAMSORT_INT32 || type == TEAMSORT_FLOAT;
+}
+
+static void sequential_job(const teamsort_job_t *job) {
+    int n = (int)job->n;
+    switch (job->type) {
+    case TEAMSORT_FLOAT:
+        float_to_ordered(job->data, 0, n);
+        sequential_sort_int32(job->data, n);
+        float_to_ordered(job->data, 0, n);
+        break;
+    case TEAMSORT_DOUBLE:
+        double_to_ordered(job->data, 0, n);
+        sequential_sort_int64(job->data, n);
+        double_to_ordered(job->data, 0, n);
+        break;
+    case TEAMSORT_INT64:
+        sequential_sort_int64(job->data, n);
+        break;
+    case TEAMSORT_UINT64:
+        sequential_sort_uint64(job->data, n);
+        break;
+    case TEAMSORT_KV:
+        sequential_sort_kv(job->data, n);
+        break;
+    default:
+        sequential_sort_int32(job->data, n);
+        break;
+    }
+}
+
+// All threads sort one large job with the context's engine
+static void parallel_job(teamsort_t *ts, const teamsort_job_t *job, int thread_id) {
+    int n = (int)job->n;
+    int type = job->type;
+    int engine = ts->engine;
+    if (engine == TEAMSORT_RADIX && !radix_type(type)) {
+        engine = TEAMSORT_BLOCK;
+    }
+
+    // Floating-point keys become ordered integers slice by slice
+    long first = (long)n * thread_id / ts->num_threads;
+    long last = (long)n * (thread_id + 1) / ts->num_threads;
+    if (type == TEAMSORT_FLOAT || type == TEAMSORT_DOUBLE) {
+        if (type == TEAMSORT_FLOAT) {
+            float_to_ordered(job->data, first, last);
+        } else {
+            double_to_ordered(job->data, first, last);
+        }
+        sort_barrier_wait(&ts->barrier, thread_id);
+    }
+
+    switch (type) {
+    case TEAMSORT_INT32:
+    case TEAMSORT_FLOAT:
+        if (engine == TEAMSORT_RADIX) {
+            enter_phase(ts, thread_id, TEAMSORT_PHASE_RADIX);
+            radix_sort(&ts->radix, job->data, ts->scratch, n, thread_id);
+            if (thread_id == 0) {
+                ts->barrier_stages += ts->radix.rounds;
+                ts->radix_last = ts->radix;
+                ts->radix_ran = 1;
+            }
+        } else if (engine == TEAMSORT_BLOCK) {
+            block_sort_int32(ts, job->data, ts->scratch, n, thread_id);
+        } else {
+            bitonic_sort_int32(ts, job->data, n, thread_id);
+        }
+        break;
+    case TEAMSORT_INT64:
+    case TEAMSORT_DOUBLE:
+        if (engine == TEAMSORT_BLOCK) {
+            block_sort_int64(ts, job->data, ts->scratch, n, thread_id);
+        } else {
+            bitonic_sort_int64(ts, job->data, n, thread_id);
+        }
+        break;
+    case TEAMSORT_UINT64:
+        if (engine == TEAMSORT_BLOCK) {
+            block_sort_uint64(ts, job->data, ts->scratch, n, thread_id);
+        } else {
+            bitonic_sort_uint64(ts, job->data, n, thread_id);
+        }
+        break;
+    case TEAMSORT_KV:
+        if (engine == TEAMSORT_BLOCK) {
+            block_sort_kv(ts, job->data, ts->scratch, n, thread_id);
+        } else {
+            bitonic_sort_kv(ts, job->data, n, thread_id);
+        }
+        break;
+    }
+
+    if (type == TEAMSORT_FLOAT || type == TEAMSORT_DOUBLE) {
+        sort_barrier_wait(&ts->barrier, thread_id);
+        if (type == TEAMSORT_FLOAT) {
+            float_to_ordered(job->data, first, last);
+        } else {
+            double_to_ordered(job->data, first, last);
+        }
+    }
+}
+
+// A freshly allocated scratch buffer is first written by the workers, one
+// slice each, so its pages land on the nodes of the threads that use them.
+// No engine writes scratch before its first stage barrier.
+static void touch_scratch(teamsort_t *ts, int thread_id) {
+    size_t slice = (ts->scratch_bytes + ts->num_threads - 1) / ts->num_threads;
+    size_t start = slice * thread_id;
+    size_t end = start + slice;
+    if (start > ts->scratch_bytes) start = ts->scratch_bytes;
+    if (end > ts->scratch_bytes) end = ts->scratch_bytes;
+    memset((char *)ts->scratch + start, 0, end - start);
+}
+
+void teamsort_worker(teamsort_t *ts, int thread_id) {
+    for (;;) {
+        // Sleep (after the spin budget) until the submitter publishes a batch
+        enter_phase(ts, thread_id, TEAMSORT_PHASE_IDLE);
+        sort_barrier_wait(&ts->dispatch, thread_id);
+        if (ts->stop) break;
+
+        if (ts->scratch_fresh) {
+            touch_scratch(ts, thread_id);
+        }
+
+        // Small jobs are claimed one at a time by whichever thread grabs them
+        for (;;) {
+            int index = __sync_fetch_and_add(&ts->next_small, 1);
+            if (index >= ts->num_jobs) break;
+            if (ts->jobs[index].n < ts->small_job) {
+                enter_phase(ts, thread_id, TEAMSORT_PHASE_LOCAL);
+                sequential_job(&ts->jobs[index]);
+                stage_boundary(ts, thread_id);
+            }
+        }
+
+        for (int i = 0; i < ts->num_jobs; i++) {
+            if (ts->jobs[i].n >= ts->small_job) {
+                parallel_job(ts, &ts->jobs[i], thread_id);
+                stage_boundary(ts, thread_id);
+            }
+        }
+
+        // The end of the batch waits for the slowest thread
+        enter_phase(ts, thread_id, TEAMSORT_PHASE_BARRIER);
+        sort_barrier_wait(&ts->dispatch, thread_id);
+    }
+}
+
+typedef struct pool_arg {
+    teamsort_t *ts;
+    int thread_id;
+} pool_arg_t;
+
+static void *pool_thread(void *arg) {
+    pool_arg_t *pool_arg = arg;
+    teamsort_t *ts = pool_arg->ts;
+
+    // Wait until the whole pool exists; a partial pool is sent home again
+    pthread_mutex_lock(&ts->pool_lock);
+    while (ts->pool_state == 0) {
+        pthread_cond_wait(&ts->pool_ready, &ts->pool_lock);
+    }
+    int state = ts->pool_state;
+    pthread_mutex_unlock(&ts->pool_lock);
+
+    if (state > 0) {
+        teamsort_worker(ts, pool_arg->thread_id);
+    }
+    return NULL;
+}
+
+teamsort_t *teamsort_create(const teamsort_config_t *config) {
+    if (config->num_threads <= 0 || config->engine < TEAMSORT_BITONIC ||
+        config->engine > TEAMSORT_RADIX || config->small_job < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    const bitonic_kernels_t *kernels = bitonic_select_kernels(config->kernels ? config->kernels : "auto");
+    if (!kernels) {
+        errno = EINVAL;
+        return NULL;
+    }
+    teamsort_t *ts = calloc(1, sizeof(teamsort_t));
+    if (!ts) return NULL;
+    ts->num_threads = config->num_threads;
+    ts->engine = config->engine;
+    ts->small_job = config->small_job > 0 ? config->small_job : TEAMSORT_SMALL_JOB;
+    ts->kernels = kernels;
+    ts->stage_hook = config->stage_hook;
+    ts->stage_arg = config->stage_arg;
+    ts->phase_hook = config->phase_hook;
+    ts->phase_arg = config->phase_arg;
+    pthread_mutex_init(&ts->pool_lock, NULL);
+    pthread_cond_init(&ts->pool_ready, NULL);
+
+    long spin_limit = config->spin_limit;
+    if (spin_limit < 0) {
+        spin_limit = sort_barrier_default_spin(config->num_threads);
+    }
+    if (sort_barrier_init(&ts->barrier, config->barrier_kind, ts->num_threads, spin_limit) != 0) {
+        int saved = errno;
+        pthread_mutex_destroy(&ts->pool_lock);
+        pthread_cond_destroy(&ts->pool_ready);
+        free(ts);
+        errno = saved;
+        return NULL;
+    }
+    if (sort_barrier_init(&ts->dispatch, config->barrier_kind, ts->num_threads + 1, spin_limit) != 0) {
+        int saved = errno;
+        sort_barrier_destroy(&ts->barrier);
+        pthread_mutex_destroy(&ts->pool_lock);
+        pthread_cond_destroy(&ts->pool_ready);
+        free(ts);
+        errno = saved;
+        return NULL;
+    }
+
+    int failed = 0;
+    if (ts->engine == TEAMSORT_RADIX) {
+        failed = radix_sort_init(&ts->radix, &ts->barrier, ts->num_threads) != 0;
+        ts->radix_ready = !failed;
+    }
+    // The radix engine falls back to the block engine for 64-bit keys
+    if (!failed && ts->engine != TEAMSORT_BITONIC) {
+        ts->block_in_scratch[0] = calloc(ts->num_threads, 1);
+        ts->block_in_scratch[1] = calloc(ts->num_threads, 1);
+        failed = !ts->block_in_scratch[0] || !ts->block_in_scratch[1];
+        if (failed) errno = ENOMEM;
+    }
+    if (failed) {
+        int saved = errno;
+        teamsort_destroy(ts);
+        errno = saved;
+        return NULL;
+    }
+    return ts;
+}
+
+int teamsort_start(teamsort_t *ts) {
+    ts->pool = calloc(ts->num_threads, sizeof(pthread_t));
+    ts->pool_args = calloc(ts->num_threads, sizeof(pool_arg_t));
+    if (!ts->pool || !ts->pool_args) {
+        free(ts->pool);
+        free(ts->pool_args);
+        ts->pool = NULL;
+        ts->pool_args = NULL;
+        errno = ENOMEM;
+        return -1;
+    }
+
+    int created = 0;
+    int result = 0;
+    while (created < ts->num_threads) {
+        ts->pool_args[created].ts = ts;
+        ts->pool_args[created].thread_id = created;
+        result = pthread_create(&ts->pool[created], NULL, pool_thread, &ts->pool_args[created]);
+        if (result != 0) break;
+        created++;
+    }
+
+    pthread_mutex_lock(&ts->pool_lock);
+    ts->pool_state = (result == 0) ? 1 : -1;
+    pthread_cond_broadcast(&ts->pool_ready);
+    pthread_mutex_unlock(&ts->pool_lock);
+
+    if (result != 0) {
+        for (int i = 0; i < created; i++) {
+            pthread_join(ts->pool[i], NULL);
+        }
+        free(ts->pool);
+        free(ts->pool_args);
+        ts->pool = NULL;
+        ts->pool_args = NULL;
+        ts->pool_state = 0;
+        errno = result;
+        return -1;
+    }
+    return 0;
+}
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int teamsort_sort(teamsort_t *ts, const teamsort_job_t *jobs, int num_jobs) {
+    // The block and radix engines need scratch space as large as the
+    // largest parallel job
+    size_t scratch_needed = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        if (jobs[i].type < TEAMSORT_INT32 || jobs[i].type > TEAMSORT_KV ||
+            jobs[i].n < 0 || jobs[i].n > TEAMSORT_MAX_N || (jobs[i].n > 0 && !jobs[i].data)) {
+            errno = EINVAL;
+            return -1;
+        }
+        size_t bytes = (size_t)jobs[i].n * element_sizes[jobs[i].type];
+        if (ts->engine != TEAMSORT_BITONIC && jobs[i].n >= ts->small_job &&
+            bytes > scratch_needed) {
+            scratch_needed = bytes;
+        }
+    }
+    if (scratch_needed > ts->scratch_bytes) {
+        // The old contents are dead, so no need to copy them over
+        free(ts->scratch);
+        ts->scratch = malloc(scratch_needed);
+        if (!ts->scratch) {
+            ts->scratch_bytes = 0;
+            errno = ENOMEM;
+            return -1;
+        }
+        ts->scratch_bytes = scratch_needed;
+        ts->scratch_fresh = 1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ts->jobs = jobs;
+    ts->num_jobs = num_jobs;
+    ts->next_small = 0;
+    sort_barrier_wait(&ts->dispatch, ts->num_threads);
+    sort_barrier_wait(&ts->dispatch, ts->num_threads);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ts->scratch_fresh = 0;
+    ts->last_batch_seconds = elapsed_seconds(&start, &end);
+    ts->batches++;
+    ts->jobs_done += num_jobs;
+    for (int i = 0; i < num_jobs; i++) {
+        ts->elements += jobs[i].n;
+    }
+    return 0;
+}
+
+static int sort_one(teamsort_t *ts, int type, void *data, long n) {
+    teamsort_job_t job = {type, data, n};
+    return teamsort_sort(ts, &job, 1);
+}
+
+int teamsort_int32(teamsort_t *ts, int32_t *data, long n) {
+    return sort_one(ts, TEAMSORT_INT32, data, n);
+}
+
+int teamsort_int64(teamsort_t *ts, int64_t *data, long n) {
+    return sort_one(ts, TEAMSORT_INT64, data, n);
+}
+
+int teamsort_uint64(teamsort_t *ts, uint64_t *data, long n) {
+    return sort_one(ts, TEAMSORT_UINT64, data, n);
+}
+
+int teamsort_float(teamsort_t *ts, float *data, long n) {
+    return sort_one(ts, TEAMSORT_FLOAT, data, n);
+}
+
+int teamsort_double(teamsort_t *ts, double *data, long n) {
+    return sort_one(ts, TEAMSORT_DOUBLE, data, n);
+}
+
+int teamsort_kv(teamsort_t *ts, teamsort_kv_t *data, long n) {
+    return sort_one(ts, TEAMSORT_KV, data, n);
+}
+
+void teamsort_stop(teamsort_t *ts) {
+    if (ts->stop) return;
+    ts->stop = 1;
+    sort_barrier_wait(&ts->dispatch, ts->num_threads);
+    if (ts->pool) {
+        for (int i = 0; i < ts->num_threads; i++) {
+            pthread_join(ts->pool[i], NULL);
+        }
+    }
+}
+
+void teamsort_destroy(teamsort_t *ts) {
+    if (!ts) return;
+    if (ts->pool) {
+        teamsort_stop(ts);
+    }
+    if (ts->radix_ready) {
+        radix_sort_destroy(&ts->radix);
+    }
+    sort_barrier_destroy(&ts->barrier);
+    sort_barrier_destroy(&ts->dispatch);
+    pthread_mutex_destroy(&ts->pool_lock);
+    pthread_cond_destroy(&ts->pool_ready);
+    free(ts->pool);
+    free(ts->pool_args);
+    free(ts->block_in_scratch[0]);
+    free(ts->block_in_scratch[1]);
+    free(ts->scratch);
+    free(ts);
+}
+
+void teamsort_get_stats(const teamsort_t *ts, teamsort_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->batches = ts->batches;
+    stats->jobs = ts->jobs_done;
+    stats->elements = ts->elements;
+    stats->barrier_stages = ts->barrier_stages;
+    stats->compare_exchanges = ts->compare_exchanges;
+    stats->merge_splits = ts->merge_splits;
+    stats->merge_splits_skipped = ts->merge_splits_skipped;
+
+    sort_barrier_summary_t summary;
+    sort_barrier_summary(&ts->barrier, &summary);
+    stats->barrier_rounds = summary.rounds;
+    stats->barrier_wait_ns = summary.total_wait_ns;
+    stats->barrier_max_wait_ns = summary.max_wait_ns;
+    stats->barrier_sleeps = summary.sleeps;
+
+    if (ts->radix_ran) {
+        stats->radix_mode = radix_sort_mode_name(ts->radix_last.mode);
+        stats->radix_counting = ts->radix_last.mode == RADIX_COUNTING;
+        stats->radix_key_min = ts->radix_last.key_min;
+        stats->radix_key_max = ts->radix_last.key_max;
+        stats->radix_passes = ts->radix_last.passes;
+        stats->radix_passes_skipped = ts->radix_last.passes_skipped;
+        stats->radix_digit_bits = ts->radix_last.digit_bits;
+    }
+    stats->last_batch_seconds = ts->last_batch_seconds;
+}
+
+const char *teamsort_kernels_name(const teamsort_t *ts) {
+    return ts->kernels->name;
+}
+
+const char *teamsort_engine_name(int engine) {
+    if (engine < TEAMSORT_BITONIC || engine > TEAMSORT_RADIX) return "unknown";
+    return engine_names[engine];
+}
@@ -0,0 +1,153 @@
+#ifndef TEAMSORT_H
+#define TEAMSORT_H
+
+#include <stdint.h>
+
+// libteamsort: the parallel sort engines of project1 as a library.
+//
+// A teamsort_t context owns everything one group of sort threads shares:
+// the stage barrier, the dispatch barrier the caller's thread uses to hand
+// over work, the radix histograms and a scratch buffer that grows with the
+// largest job seen. Nothing lives in globals, so independent contexts can
+// sort concurrently in one process.
+//
+// The worker threads either belong to the library (teamsort_start) or to
+// the caller, who runs teamsort_worker on each of them, e.g. to pin them or
+// to give them a signal mask. In both cases the calling thread submits
+// batches with teamsort_sort and the workers stay warm in between: small
+// jobs (below TEAMSORT_SMALL_JOB elements unless configured otherwise) are
+// claimed and sorted by one thread each, larger jobs run one after another
+// on all threads.
+//
+// Key types:
+//  - int32, int64, uint64: ascending numeric order;
+//  - float, double: IEEE 754 totalOrder (-NaN < -inf < ... < -0 < +0 <
+//    ... < +inf < +NaN). The bits are mapped in place onto signed integers
+//    with the same order, sorted as int32/int64, and mapped back;
+//  - teamsort_kv_t: records ordered by an int64 key, the 64-bit payload
+//    moving with its key (not stable between equal keys).
+// The radix engine handles int32 and float keys; the other types fall back
+// to the block engine.
+
+#define TEAMSORT_BITONIC 0      // Element-level bitonic network over the whole array
+#define TEAMSORT_BLOCK   1      // Per-thread local sort + block merge-split network
+#define TEAMSORT_RADIX   2      // Counting sort or LSD radix passes (32-bit keys)
+
+#define TEAMSORT_INT32  0
+#define TEAMSORT_INT64  1
+#define TEAMSORT_UINT64 2
+#define TEAMSORT_FLOAT  3
+#define TEAMSORT_DOUBLE 4
+#define TEAMSORT_KV     5
+
+#define TEAMSORT_SMALL_JOB 32768    // Jobs below this are sorted by one thread
+#define TEAMSORT_MAX_N (1L << 30)   // Largest job: the network's power-of-2 span stays an int
+
+// Phases a worker reports to the phase hook
+#define TEAMSORT_PHASE_IDLE     0   // Waiting for the next batch
+#define TEAMSORT_PHASE_LOCAL    1   // Sequential sorts: small jobs, block engine local sorts
+#define TEAMSORT_PHASE_RADIX    2   // Radix engine, its barriers included
+#define TEAMSORT_PHASE_BARRIER  3   // Waiting at a stage barrier
+#define TEAMSORT_PHASE_MERGE    4   // Plus log2 of the merge size k: network stages of one merge
+#define TEAMSORT_PHASES         (TEAMSORT_PHASE_MERGE + 32)
+
+typedef struct {
+    int64_t key;
+    uint64_t value;
+} teamsort_kv_t;
+
+typedef struct {
+    int type;           // TEAMSORT_INT32 ... TEAMSORT_KV
+    void *data;
+    long n;             // Elements, at most TEAMSORT_MAX_N
+} teamsort_job_t;
+
+typedef struct {
+    int num_threads;
+    int engine;             // TEAMSORT_BITONIC, TEAMSORT_BLOCK or TEAMSORT_RADIX
+    int barrier_kind;       // SORT_BARRIER_FUTEX or SORT_BARRIER_PTHREAD
+    long spin_limit;        // Futex barrier spin budget, -1 for the default
+    const char *kernels;    // Compare-exchange kernel set, NULL for "auto"
+    long small_job;         // Jobs below this many elements go to one
+                            // thread; 0 for TEAMSORT_SMALL_JOB
+    // Optional, NULL for none: called on every worker after each stage
+    // barrier and after each job, where no thread is inside a stage, e.g.
+    // to take messages from a mailbox. Must not wait for other workers.
+    void (*stage_hook)(void *arg, int thread_id);
+    void *stage_arg;
+    // Optional, NULL for none: called on a worker whenever it enters a
+    // TEAMSORT_PHASE_*, e.g. to attribute performance counters to phases.
+    // For the block engine the merge size counts blocks, not elements.
+    void (*phase_hook)(void *arg, int thread_id, int phase);
+    void *phase_arg;
+} teamsort_config_t;
+
+// Cumulative over the life of the context
+typedef struct {
+    long long batches;
+    long long jobs;
+    long long elements;
+    long long barrier_stages;       // Stage barriers inside the engines
+    long long compare_exchanges;    // Bitonic engine
+    long long merge_splits;         // Block engine
+    long long merge_splits_skipped; // Block pairs that were already ordered
+    // Stage barrier wait time, summed over all threads
+    long long barrier_rounds;
+    long long barrier_wait_ns;
+    long long barrier_max_wait_ns;
+    long long barrier_sleeps;
+    // Shape of the last radix sort
+    const char *radix_mode;         // NULL until the radix engine ran
+    int radix_counting;             // One counting pass rather than LSD passes
+    int radix_key_min;
+    int radix_key_max;
+    int radix_passes;
+    int radix_passes_skipped;
+    int radix_digit_bits;
+    // Wall-clock time of the most recent teamsort_sort, from submitting the
+    // batch until every job was done; 0 before the first batch
+    double last_batch_seconds;
+} teamsort_stats_t;
+
+typedef struct teamsort teamsort_t;
+
+// Returns a new context, or NULL with errno set (EINVAL for a bad
+// configuration or an unknown/unsupported kernel set)
+teamsort_t *teamsort_create(const teamsort_config_t *config);
+
+// Start a pool of config->num_threads library-owned workers. Returns 0, or
+// -1 with errno set. Not needed when the caller runs teamsort_worker itself.
+int teamsort_start(teamsort_t *ts);
+
+// Worker loop for caller-owned threads: each of the num_threads threads
+// calls it once with its own thread_id in [0, num_threads). Returns after
+// teamsort_stop.
+void teamsort_worker(teamsort_t *ts, int thread_id);
+
+// Sort every job of the batch in place and return when all are done. Only
+// one thread may submit at a time. Returns 0, or -1 with errno set (EINVAL
+// for a bad job or one over TEAMSORT_MAX_N elements, ENOMEM if the scratch
+// buffer cannot grow).
+int teamsort_sort(teamsort_t *ts, const teamsort_job_t *jobs, int num_jobs);
+
+// One-job wrappers
+int teamsort_int32(teamsort_t *ts, int32_t *data, long n);
+int teamsort_int64(teamsort_t *ts, int64_t *data, long n);
+int teamsort_uint64(teamsort_t *ts, uint64_t *data, long n);
+int teamsort_float(teamsort_t *ts, float *data, long n);
+int teamsort_double(teamsort_t *ts, double *data, long n);
+int teamsort_kv(teamsort_t *ts, teamsort_kv_t *data, long n);
+
+// Release the workers from teamsort_worker; library-owned ones are also
+// joined. Caller-owned workers must all be running teamsort_worker.
+void teamsort_stop(teamsort_t *ts);
+
+// Stops a library-owned pool if still running and frees the context
+void teamsort_destroy(teamsort_t *ts);
+
+void teamsort_get_stats(const teamsort_t *ts, teamsort_stats_t *stats);
+
+const char *teamsort_kernels_name(const teamsort_t *ts);
+const char *teamsort_engine_name(int engine);
+
+#endif
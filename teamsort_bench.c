@@ -0,0 +1,483 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <getopt.h>
+#include "teamsort.h"
+#include "sort_barrier.h"
+#include "input_gen.h"
+
+// Benchmark driver for libteamsort: sweeps array sizes, threads per team,
+// engines and input distributions in one process. Each configuration gets
+// its own context with library-owned workers, which stay warm across the
+// sizes and distributions it sorts. Every point is sorted --warmup times
+// unmeasured, then --trials times; the input is regenerated from the seed
+// once and copied back before each trial, and each trial is verified.
+//
+// Results go to stdout as a table and optionally to CSV and JSON files
+// with a fixed row order and number format, so two runs diff line by line.
+// --baseline reads a CSV written earlier and flags every point whose
+// median time grew by more than --tolerance percent.
+
+#define NUM_TEAMS 4                 // Same team count as project1
+#define KEY_RANGE 10000             // Same key range as project1
+#define MAX_VALUES 32
+#define MAX_BASELINE 4096
+
+typedef struct {
+    const char *engine;
+    const char *dist;
+    long size;
+    int threads_per_team;
+    int trials;
+    double median;
+    double p95;
+    double mean;
+    double stddev;
+    double min;
+} bench_result_t;
+
+typedef struct {
+    char engine[16];
+    char dist[16];
+    long size;
+    int threads_per_team;
+    double median;
+} baseline_row_t;
+
+long sizes[MAX_VALUES];
+int num_sizes = 0;
+int thread_counts[MAX_VALUES];
+int num_thread_counts = 0;
+int engines[MAX_VALUES];
+int num_engines = 0;
+int dists[MAX_VALUES];
+int num_dists = 0;
+int warmup = 1;
+int trials = 5;
+unsigned long long seed = 1;
+int barrier_kind = SORT_BARRIER_FUTEX;
+
+bench_result_t *results = NULL;
+int num_results = 0;
+baseline_row_t baseline[MAX_BASELINE];
+int num_baseline = 0;
+
+// Function declarations
+void print_usage(const char *prog);
+int parse_list(const char *list, int kind);
+int engine_parse(const char *name);
+double elapsed_seconds(const struct timespec *start, const struct timespec *end);
+void summarize(double *seconds, int n, bench_result_t *result);
+int run_point(teamsort_t *ts, int engine, int dist, long size, int threads_per_team,
+              int *input, int *work, double *seconds);
+int write_csv(const char *path);
+int write_json(const char *path);
+int load_baseline(const char *path);
+int compare_baseline(double tolerance);
+
+void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\nOptions (lists are comma separated):\n");
+    printf("  --sizes=LIST      Array sizes (default 100000,1000000)\n");
+    printf("  --threads=LIST    Threads per team, %d teams (default 1,2,4)\n", NUM_TEAMS);
+    printf("  --algos=LIST      Engines: bitonic, block, radix (default all three)\n");
+    printf("  --dists=LIST      Input distributions: uniform, sorted, reversed, few-unique,\n");
+    printf("                    zipf, organ-pipe (default uniform)\n");
+    printf("  --warmup=N        Unmeasured sorts per point (default 1)\n");
+    printf("  --trials=N        Measured sorts per point (default 5)\n");
+    printf("  --seed=N          Input seed (default 1)\n");
+    printf("  --barrier=KIND    Stage barrier: futex (default) or pthread\n");
+    printf("  --csv=FILE        Write the results as CSV\n");
+    printf("  --json=FILE       Write the results as JSON\n");
+    printf("  --baseline=FILE   Compare against a CSV from an earlier run; exit status 2\n");
+    printf("                    if any point regressed\n");
+    printf("  --tolerance=PCT   Median slowdown that counts as a regression (default 5)\n");
+    printf("  -h, --help        Show this help\n");
+    printf("\nExample: %s --sizes=1000000 --threads=1,4 --csv=bench.csv\n", prog);
+    printf("         %s --baseline=bench.csv --tolerance=10\n", prog);
+}
+
+int engine_parse(const char *name) {
+    if (strcmp(name, "bitonic") == 0) return TEAMSORT_BITONIC;
+    if (strcmp(name, "block") == 0) return TEAMSORT_BLOCK;
+    if (strcmp(name, "radix") == 0) return TEAMSORT_RADIX;
+    return -1;
+}
+
+// Short names as on the command line and in the CSV
+static const char *engine_key(int engine) {
+    switch (engine) {
+    case TEAMSORT_BLOCK: return "block";
+    case TEAMSORT_RADIX: return "radix";
+    default: return "bitonic";
+    }
+}
+
+// kind: 's' sizes, 't' threads, 'a' engines, 'd' distributions.
+// Returns 0, or -1 for a bad or too long list.
+int parse_list(const char *list, int kind) {
+    char buffer[256];
+    if (strlen(list) >= sizeof(buffer)) return -1;
+    strcpy(buffer, list);
+    int count = 0;
+    for (char *item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        if (count == MAX_VALUES) return -1;
+        char *end;
+        if (kind == 's') {
+            long size = strtol(item, &end, 10);
+            if (*end || size <= 0) return -1;
+            sizes[count++] = size;
+        } else if (kind == 't') {
+            long threads = strtol(item, &end, 10);
+            if (*end || threads <= 0 || threads > 10000) return -1;
+            thread_counts[count++] = (int)threads;
+        } else if (kind == 'a') {
+            int engine = engine_parse(item);
+            if (engine < 0) return -1;
+            engines[count++] = engine;
+        } else {
+            int dist = input_dist_parse(item);
+            if (dist < 0) return -1;
+            dists[count++] = dist;
+        }
+    }
+    if (count == 0) return -1;
+    switch (kind) {
+    case 's': num_sizes = count; break;
+    case 't': num_thread_counts = count; break;
+    case 'a': num_engines = count; break;
+    default: num_dists = count; break;
+    }
+    return 0;
+}
+
+double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Sorts seconds[0..n) in place. p95 is the nearest-rank percentile;
+// stddev is the sample standard deviation (0 for one trial).
+void summarize(double *seconds, int n, bench_result_t *result) {
+    for (int i = 1; i < n; i++) {
+        double value = seconds[i];
+        int j = i - 1;
+        while (j >= 0 && seconds[j] > value) {
+            seconds[j + 1] = seconds[j];
+            j--;
+        }
+        seconds[j + 1] = value;
+    }
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += seconds[i];
+    }
+    double mean = sum / n;
+    double squares = 0;
+    for (int i = 0; i < n; i++) {
+        squares += (seconds[i] - mean) * (seconds[i] - mean);
+    }
+    int rank = (int)ceil(0.95 * n);
+    result->trials = n;
+    result->median = n % 2 ? seconds[n / 2] : (seconds[n / 2 - 1] + seconds[n / 2]) / 2;
+    result->p95 = seconds[rank > 0 ? rank - 1 : 0];
+    result->mean = mean;
+    result->stddev = n > 1 ? sqrt(squares / (n - 1)) : 0;
+    result->min = seconds[0];
+}
+
+// Warm up, then time the trials of one point into seconds[]. Returns 0,
+// or -1 if a sort failed or left the array unsorted.
+int run_point(teamsort_t *ts, int engine, int dist, long size, int threads_per_team,
+              int *input, int *work, double *seconds) {
+    for (int run = -warmup; run < trials; run++) {
+        memcpy(work, input, size * sizeof(int));
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (teamsort_int32(ts, work, size) != 0) {
+            printf("[ERROR] Sort failed: %s\n", strerror(errno));
+            return -1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        for (long i = 1; i < size; i++) {
+            if (work[i - 1] > work[i]) {
+                printf("[ERROR] %s, %s, %ld elements, %d threads per team: not sorted at %ld\n",
+                       engine_key(engine), input_dist_name(dist), size, threads_per_team, i);
+                return -1;
+            }
+        }
+        if (run >= 0) seconds[run] = elapsed_seconds(&start, &end);
+    }
+    return 0;
+}
+
+int write_csv(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) return -1;
+    fprintf(file, "engine,dist,size,threads_per_team,threads,trials,"
+                  "median_s,p95_s,mean_s,stddev_s,min_s,elements_per_s\n");
+    for (int i = 0; i < num_results; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(file, "%s,%s,%ld,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.0f\n",
+                r->engine, r->dist, r->size, r->threads_per_team, NUM_TEAMS * r->threads_per_team,
+                r->trials, r->median, r->p95, r->mean, r->stddev, r->min, r->size / r->median);
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+int write_json(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) return -1;
+    fprintf(file, "{\n  \"warmup\": %d,\n  \"seed\": %llu,\n  \"results\": [\n", warmup, seed);
+    for (int i = 0; i < num_results; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(file, "    {\"engine\": \"%s\", \"dist\": \"%s\", \"size\": %ld, "
+                      "\"threads_per_team\": %d, \"threads\": %d, \"trials\": %d, "
+                      "\"median_s\": %.6f, \"p95_s\": %.6f, \"mean_s\": %.6f, "
+                      "\"stddev_s\": %.6f, \"min_s\": %.6f, \"elements_per_s\": %.0f}%s\n",
+                r->engine, r->dist, r->size, r->threads_per_team, NUM_TEAMS * r->threads_per_team,
+                r->trials, r->median, r->p95, r->mean, r->stddev, r->min, r->size / r->median,
+                i + 1 < num_results ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+// Keeps engine, dist, size, threads_per_team and median_s of every row.
+// Returns 0, or -1 with errno set (EINVAL for a malformed file).
+int load_baseline(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+    char line[512];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        if (line_number == 1) continue;         // Header
+        if (num_baseline == MAX_BASELINE) break;
+        baseline_row_t *row = &baseline[num_baseline];
+        int threads, trial_count;
+        if (sscanf(line, "%15[^,],%15[^,],%ld,%d,%d,%d,%lf", row->engine, row->dist, &row->size,
+                   &row->threads_per_team, &threads, &trial_count, &row->median) != 7) {
+            fclose(file);
+            errno = EINVAL;
+            return -1;
+        }
+        num_baseline++;
+    }
+    fclose(file);
+    return 0;
+}
+
+// Prints one line per point that has a baseline. Returns the number of
+// regressions.
+int compare_baseline(double tolerance) {
+    int regressions = 0, matched = 0;
+    printf("\n=== BASELINE COMPARISON (tolerance %.1f%%) ===\n", tolerance);
+    printf("%-8s %-11s %10s %8s %12s %12s %9s\n", "engine", "dist", "size", "threads",
+           "baseline s", "median s", "change");
+    for (int i = 0; i < num_results; i++) {
+        const bench_result_t *r = &results[i];
+        for (int b = 0; b < num_baseline; b++) {
+            const baseline_row_t *row = &baseline[b];
+            if (strcmp(row->engine, r->engine) != 0 || strcmp(row->dist, r->dist) != 0 ||
+                row->size != r->size || row->threads_per_team != r->threads_per_team) {
+                continue;
+            }
+            double change = 100.0 * (r->median - row->median) / row->median;
+            int regressed = change > tolerance;
+            printf("%-8s %-11s %10ld %8d %12.6f %12.6f %+8.1f%%%s\n", r->engine, r->dist, r->size,
+                   r->threads_per_team, row->median, r->median, change,
+                   regressed ? "  REGRESSION" : "");
+            regressions += regressed;
+            matched++;
+            break;
+        }
+    }
+    printf("%d of %d points compared, %d regression%s\n", matched, num_results, regressions,
+           regressions == 1 ? "" : "s");
+    return regressions;
+}
+
+int main(int argc, char *argv[]) {
+    static struct option long_options[] = {
+        {"sizes",     required_argument, NULL, 's'},
+        {"threads",   required_argument, NULL, 't'},
+        {"algos",     required_argument, NULL, 'a'},
+        {"dists",     required_argument, NULL, 'd'},
+        {"warmup",    required_argument, NULL, 'w'},
+        {"trials",    required_argument, NULL, 'n'},
+        {"seed",      required_argument, NULL, 'S'},
+        {"barrier",   required_argument, NULL, 'b'},
+        {"csv",       required_argument, NULL, 'c'},
+        {"json",      required_argument, NULL, 'j'},
+        {"baseline",  required_argument, NULL, 'B'},
+        {"tolerance", required_argument, NULL, 'T'},
+        {"help",      no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    const char *csv_path = NULL, *json_path = NULL, *baseline_path = NULL;
+    double tolerance = 5.0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+        case 't':
+        case 'a':
+        case 'd':
+            if (parse_list(optarg, opt) != 0) {
+                printf("[ERROR] Invalid list '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'w':
+            warmup = atoi(optarg);
+            if (warmup < 0) {
+                printf("[ERROR] Invalid warm-up count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            trials = atoi(optarg);
+            if (trials <= 0 || trials > 1000) {
+                printf("[ERROR] Invalid trial count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'S':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'b':
+            if (strcmp(optarg, "futex") == 0) {
+                barrier_kind = SORT_BARRIER_FUTEX;
+            } else if (strcmp(optarg, "pthread") == 0) {
+                barrier_kind = SORT_BARRIER_PTHREAD;
+            } else {
+                printf("[ERROR] Unknown barrier '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            csv_path = optarg;
+            break;
+        case 'j':
+            json_path = optarg;
+            break;
+        case 'B':
+            baseline_path = optarg;
+            break;
+        case 'T':
+            tolerance = atof(optarg);
+            if (tolerance < 0) {
+                printf("[ERROR] Invalid tolerance %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'h':
+        default:
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind < argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (num_sizes == 0) parse_list("100000,1000000", 's');
+    if (num_thread_counts == 0) parse_list("1,2,4", 't');
+    if (num_engines == 0) parse_list("bitonic,block,radix", 'a');
+    if (num_dists == 0) parse_list("uniform", 'd');
+
+    // Read the baseline first: a typo should not cost a whole sweep
+    if (baseline_path && load_baseline(baseline_path) != 0) {
+        printf("[ERROR] Failed to read baseline %s: %s\n", baseline_path, strerror(errno));
+        return 1;
+    }
+
+    long max_size = 0;
+    for (int i = 0; i < num_sizes; i++) {
+        if (sizes[i] > max_size) max_size = sizes[i];
+    }
+    int *input = malloc(max_size * sizeof(int));
+    int *work = malloc(max_size * sizeof(int));
+    double *seconds = malloc(trials * sizeof(double));
+    results = malloc((size_t)num_engines * num_thread_counts * num_dists * num_sizes *
+                     sizeof(bench_result_t));
+    if (!input || !work || !seconds || !results) {
+        printf("[ERROR] Failed to allocate benchmark buffers: %s\n", strerror(errno));
+        return 1;
+    }
+
+    printf("=== TEAMSORT BENCHMARK ===\n");
+    printf("%d teams, %s barrier, seed %llu, %d warm-up + %d measured sorts per point\n",
+           NUM_TEAMS, sort_barrier_kind_name(barrier_kind), seed, warmup, trials);
+    printf("%-8s %-11s %10s %8s %11s %11s %11s %9s %14s\n", "engine", "dist", "size", "threads",
+           "median s", "p95 s", "stddev s", "stddev %", "elements/s");
+
+    int failed = 0;
+    for (int e = 0; e < num_engines && !failed; e++) {
+        for (int t = 0; t < num_thread_counts && !failed; t++) {
+            int threads_per_team = thread_counts[t];
+            // Always the parallel engine, like project1's array mode
+            teamsort_config_t config = {
+                NUM_TEAMS * threads_per_team, engines[e], barrier_kind, -1, NULL, 1,
+                NULL, NULL, NULL, NULL
+            };
+            teamsort_t *ts = teamsort_create(&config);
+            if (!ts || teamsort_start(ts) != 0) {
+                printf("[ERROR] Failed to start %d sort threads: %s\n", config.num_threads,
+                       strerror(errno));
+                return 1;
+            }
+            for (int d = 0; d < num_dists && !failed; d++) {
+                for (int s = 0; s < num_sizes && !failed; s++) {
+                    input_gen_t gen;
+                    if (input_gen_init(&gen, dists[d], seed, sizes[s], KEY_RANGE) != 0) {
+                        printf("[ERROR] Failed to initialize input generator: %s\n",
+                               strerror(errno));
+                        return 1;
+                    }
+                    input_gen_fill(&gen, input, 0, sizes[s]);
+                    input_gen_destroy(&gen);
+
+                    if (run_point(ts, engines[e], dists[d], sizes[s], threads_per_team,
+                                  input, work, seconds) != 0) {
+                        failed = 1;
+                        break;
+                    }
+                    bench_result_t *r = &results[num_results++];
+                    r->engine = engine_key(engines[e]);
+                    r->dist = input_dist_name(dists[d]);
+                    r->size = sizes[s];
+                    r->threads_per_team = threads_per_team;
+                    summarize(seconds, trials, r);
+                    printf("%-8s %-11s %10ld %8d %11.6f %11.6f %11.6f %8.1f%% %14.0f\n",
+                           r->engine, r->dist, r->size, r->threads_per_team, r->median, r->p95,
+                           r->stddev, 100.0 * r->stddev / r->mean, r->size / r->median);
+                    fflush(stdout);
+                }
+            }
+            teamsort_destroy(ts);
+        }
+    }
+
+    int status = failed ? 1 : 0;
+    if (csv_path && write_csv(csv_path) != 0) {
+        printf("[ERROR] Failed to write %s: %s\n", csv_path, strerror(errno));
+        status = 1;
+    }
+    if (json_path && write_json(json_path) != 0) {
+        printf("[ERROR] Failed to write %s: %s\n", json_path, strerror(errno));
+        status = 1;
+    }
+    if (baseline_path && !failed && compare_baseline(tolerance) > 0 && status == 0) {
+        status = 2;
+    }
+
+    free(input);
+    free(work);
+    free(seconds);
+    free(results);
+    return status;
+}
@@ -0,0 +1,270 @@
+// Type-specialized engines for teamsort.c. Included once per key type with
+//
+//   TS_TYPE        element type
+//   TS_SUFFIX      name suffix of the generated functions
+//   TS_LESS(a, b)  strict weak order on elements
+//   TS_STAGE       optional: function with bitonic_stage's arguments that
+//                  runs one thread's share of a network stage (the int32
+//                  instance uses the SIMD kernels); the generic scalar
+//                  stage is used otherwise
+//
+// and undefines them again at the end. The algorithms are the ones
+// described in teamsort.c; only the element type and order change.
+
+#define TS_CONCAT(name, suffix) name##_##suffix
+#define TS_EXPAND(name, suffix) TS_CONCAT(name, suffix)
+#define TS_FN(name) TS_EXPAND(name, TS_SUFFIX)
+
+// Quicksort with median-of-3 Hoare partitioning and an insertion sort
+// cutoff. Recurses into the smaller side only, so stack depth is O(log n).
+static void TS_FN(sequential_sort)(TS_TYPE *arr, int n) {
+    while (n > INSERTION_SORT_CUTOFF) {
+        // Move the median of first/middle/last to arr[0] as the pivot
+        int mid = n / 2;
+        TS_TYPE a = arr[0], b = arr[mid], c = arr[n - 1];
+        int m = TS_LESS(a, b) ? (TS_LESS(b, c) ? mid : (TS_LESS(a, c) ? n - 1 : 0))
+                              : (TS_LESS(a, c) ? 0 : (TS_LESS(b, c) ? n - 1 : mid));
+        TS_TYPE temp = arr[0];
+        arr[0] = arr[m];
+        arr[m] = temp;
+
+        TS_TYPE pivot = arr[0];
+        int i = -1, j = n;
+        for (;;) {
+            do { i++; } while (TS_LESS(arr[i], pivot));
+            do { j--; } while (TS_LESS(pivot, arr[j]));
+            if (i >= j) break;
+            temp = arr[i];
+            arr[i] = arr[j];
+            arr[j] = temp;
+        }
+
+        // Partitions are [0, j] and [j + 1, n)
+        int left = j + 1;
+        if (left < n - left) {
+            TS_FN(sequential_sort)(arr, left);
+            arr += left;
+            n -= left;
+        } else {
+            TS_FN(sequential_sort)(arr + left, n - left);
+            n = left;
+        }
+    }
+
+    for (int i = 1; i < n; i++) {
+        TS_TYPE value = arr[i];
+        int j = i - 1;
+        while (j >= 0 && TS_LESS(value, arr[j])) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = value;
+    }
+}
+
+// One half of a merge-split between two sorted blocks. The lower partner
+// (keep_low) writes the low_len smallest elements of the union to out, the
+// upper partner writes the high_len largest ones, merging from the back.
+static void TS_FN(merge_split)(const TS_TYPE *low, int low_len, const TS_TYPE *high, int high_len,
+                               TS_TYPE *out, int keep_low) {
+    if (keep_low) {
+        int i = 0, j = 0;
+        for (int k = 0; k < low_len; k++) {
+            if (j >= high_len || (i < low_len && !TS_LESS(high[j], low[i]))) {
+                out[k] = low[i++];
+            } else {
+                out[k] = high[j++];
+            }
+        }
+    } else {
+        int i = low_len - 1, j = high_len - 1;
+        for (int k = high_len - 1; k >= 0; k--) {
+            if (i < 0 || (j >= 0 && !TS_LESS(high[j], low[i]))) {
+                out[k] = high[j--];
+            } else {
+                out[k] = low[i--];
+            }
+        }
+    }
+}
+
+#ifndef TS_STAGE
+static void TS_FN(compare_exchange)(TS_TYPE *lo, TS_TYPE *hi) {
+    if (TS_LESS(*hi, *lo)) {
+        TS_TYPE temp = *lo;
+        *lo = *hi;
+        *hi = temp;
+    }
+}
+
+// Scalar counterpart of bitonic_stage: this thread's share of the live
+// pairs of stage (k, j), walked as contiguous spans inside one block
+static void TS_FN(stage)(const bitonic_kernels_t *kernels, TS_TYPE *arr, int n, int k, int j,
+                         int thread_id, int num_threads) {
+    (void)kernels;
+    int flip = (j == k >> 1);
+    long block = 2L * j;
+    long num_pairs = bitonic_stage_pairs(n, j);
+    long pairs_per_thread = (num_pairs + num_threads - 1) / num_threads;
+    long p = (long)thread_id * pairs_per_thread;
+    long pair_end = p + pairs_per_thread;
+    if (pair_end > num_pairs) pair_end = num_pairs;
+
+    long full_pairs = (n / block) * j;
+    long remainder = n % block;
+
+    while (p < pair_end) {
+        long base, off, span;
+        if (p < full_pairs) {
+            base = (p / j) * block;
+            off = p % j;
+            span = j - off;
+        } else {
+            // Trailing partial block: only pairs with upper element < n
+            base = (n / block) * block;
+            off = (flip ? block - remainder : 0) + (p - full_pairs);
+            span = pair_end - p;
+        }
+        if (span > pair_end - p) span = pair_end - p;
+
+        TS_TYPE *lo = arr + base + off;
+        if (flip) {
+            TS_TYPE *hi_end = arr + base + block - 1 - off;
+            for (long t = 0; t < span; t++) {
+                TS_FN(compare_exchange)(lo + t, hi_end - t);
+            }
+        } else {
+            for (long t = 0; t < span; t++) {
+                TS_FN(compare_exchange)(lo + t, lo + t + j);
+            }
+        }
+        p += span;
+    }
+}
+#define TS_STAGE TS_FN(stage)
+#endif
+
+// Bitonic network over any n elements, one barrier per stage
+static void TS_FN(bitonic_sort)(teamsort_t *ts, TS_TYPE *arr, int n, int thread_id) {
+    int top = next_power_of_2(n);
+
+    for (int k = 2; k <= top; k <<= 1) {
+        for (int j = k >> 1; j > 0; j >>= 1) {
+            long num_pairs = bitonic_stage_pairs(n, j);
+            if (num_pairs == 0) continue;
+
+            enter_phase(ts, thread_id, merge_phase(k));
+            TS_STAGE(ts->kernels, arr, n, k, j, thread_id, ts->num_threads);
+
+            enter_phase(ts, thread_id, TEAMSORT_PHASE_BARRIER);
+            sort_barrier_wait(&ts->barrier, thread_id);
+            if (thread_id == 0) {
+                ts->barrier_stages++;
+                ts->compare_exchanges += num_pairs;
+            }
+            stage_boundary(ts, thread_id);
+        }
+    }
+}
+
+// Block-bitonic hybrid: local sorts, then the network over the blocks with
+// merge-splits as comparators, ping-ponging between arr and scratch
+static void TS_FN(block_sort)(teamsort_t *ts, TS_TYPE *arr, TS_TYPE *scratch, int n, int thread_id) {
+    int num_threads = ts->num_threads;
+    int block_size = (n + num_threads - 1) / num_threads;
+    int my_start = thread_id * block_size;
+    if (my_start > n) my_start = n;
+    int my_len = (my_start + block_size > n) ? n - my_start : block_size;
+
+    enter_phase(ts, thread_id, TEAMSORT_PHASE_LOCAL);
+    TS_FN(sequential_sort)(arr + my_start, my_len);
+
+    int in_scratch = 0;
+    int stage = 0;
+    ts->block_in_scratch[0][thread_id] = 0;
+    enter_phase(ts, thread_id, TEAMSORT_PHASE_BARRIER);
+    sort_barrier_wait(&ts->barrier, thread_id);
+    if (thread_id == 0) {
+        ts->barrier_stages++;
+    }
+    stage_boundary(ts, thread_id);
+
+    int top = next_power_of_2(num_threads);
+    for (int k = 2; k <= top; k <<= 1) {
+        for (int j = k >> 1; j > 0; j >>= 1) {
+            if (bitonic_stage_pairs(num_threads, j) == 0) continue;
+            enter_phase(ts, thread_id, merge_phase(k));
+
+            // Locate this block's partner inside its group of 2*j blocks
+            int flip = (j == k >> 1);
+            int base = thread_id & ~(2 * j - 1);
+            int pos = thread_id - base;
+            int partner;
+            if (flip) {
+                partner = base + 2 * j - 1 - pos;
+            } else {
+                partner = (pos < j) ? thread_id + j : thread_id - j;
+            }
+            int keep_low = thread_id < partner;
+
+            int partner_start = partner * block_size;
+            if (partner_start > n) partner_start = n;
+            int partner_len = 0;
+            if (partner < num_threads) {
+                partner_len = (partner_start + block_size > n) ? n - partner_start : block_size;
+            }
+
+            if (my_len > 0 && partner_len > 0) {
+                int partner_in_scratch = ts->block_in_scratch[stage & 1][partner];
+                const TS_TYPE *mine = (in_scratch ? scratch : arr) + my_start;
+                const TS_TYPE *theirs = (partner_in_scratch ? scratch : arr) + partner_start;
+                const TS_TYPE *low = keep_low ? mine : theirs;
+                const TS_TYPE *high = keep_low ? theirs : mine;
+                int low_len = keep_low ? my_len : partner_len;
+                int high_len = keep_low ? partner_len : my_len;
+
+                // Already ordered blocks need no exchange
+                if (!TS_LESS(high[0], low[low_len - 1])) {
+                    if (keep_low) {
+                        __sync_fetch_and_add(&ts->merge_splits_skipped, 1);
+                    }
+                } else {
+                    TS_TYPE *out = (in_scratch ? arr : scratch) + my_start;
+                    TS_FN(merge_split)(low, low_len, high, high_len, out, keep_low);
+                    in_scratch = !in_scratch;
+                    if (keep_low) {
+                        __sync_fetch_and_add(&ts->merge_splits, 1);
+                    }
+                }
+            }
+
+            ts->block_in_scratch[(stage + 1) & 1][thread_id] = (unsigned char)in_scratch;
+            stage++;
+
+            enter_phase(ts, thread_id, TEAMSORT_PHASE_BARRIER);
+            sort_barrier_wait(&ts->barrier, thread_id);
+            if (thread_id == 0) {
+                ts->barrier_stages++;
+            }
+            stage_boundary(ts, thread_id);
+        }
+    }
+
+    // Move blocks that ended up in the scratch buffer back into place
+    if (in_scratch) {
+        memcpy(arr + my_start, scratch + my_start, my_len * sizeof(TS_TYPE));
+    }
+    enter_phase(ts, thread_id, TEAMSORT_PHASE_BARRIER);
+    sort_barrier_wait(&ts->barrier, thread_id);
+    if (thread_id == 0) {
+        ts->barrier_stages++;
+    }
+}
+
+#undef TS_STAGE
+#undef TS_FN
+#undef TS_EXPAND
+#undef TS_CONCAT
+#undef TS_TYPE
+#undef TS_SUFFIX
+#undef TS_LESS
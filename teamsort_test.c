@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "teamsort.h"
+#include "sort_barrier.h"
+
+// Checks for libteamsort, run by make test_quick. Every engine gets a
+// context with library-owned workers that sends every job to the engine,
+// then one with the default small-job threshold for a mixed batch. Each
+// check prints one [TEST] line; the exit status is 1 if any of them failed.
+
+#define NUM_THREADS 4
+#define LARGE_N 100003      // Odd, and not a power of 2 on any engine
+
+int failures = 0;
+
+// Function declarations
+void check(int ok, const char *engine, const char *what);
+void check_job_limits(teamsort_t *ts, const char *engine);
+void check_int32_sizes(teamsort_t *ts, const char *engine);
+void check_float_order(teamsort_t *ts, const char *engine);
+void check_double_order(teamsort_t *ts, const char *engine);
+void check_radix_shapes(teamsort_t *ts, const char *engine);
+void check_int64_order(teamsort_t *ts, const char *engine);
+void check_uint64_order(teamsort_t *ts, const char *engine);
+void check_kv_payload(teamsort_t *ts, const char *engine);
+void check_mixed_batch(teamsort_t *ts, const char *engine);
+
+void check(int ok, const char *engine, const char *what) {
+    printf("[TEST] %s: %s: %s\n", engine, what, ok ? "PASSED" : "FAILED");
+    if (!ok) failures++;
+}
+
+// Jobs over TEAMSORT_MAX_N are refused before any element is touched
+void check_job_limits(teamsort_t *ts, const char *engine) {
+    int32_t keys[2] = {2, 1};
+    errno = 0;
+    int result = teamsort_int32(ts, keys, TEAMSORT_MAX_N + 1);
+    check(result == -1 && errno == EINVAL && keys[0] == 2,
+          engine, "job over TEAMSORT_MAX_N rejected with EINVAL");
+    errno = 0;
+    result = teamsort_int32(ts, keys, -1);
+    check(result == -1 && errno == EINVAL, engine, "negative job size rejected with EINVAL");
+    result = teamsort_int32(ts, keys, 2);
+    check(result == 0 && keys[0] == 1 && keys[1] == 2, engine, "context usable after a rejected job");
+}
+
+static int compare_int32(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a, y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// totalOrder of the bit patterns: flip the magnitude bits of negatives
+static int compare_float_bits(const void *a, const void *b) {
+    int32_t x, y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    x ^= (x >> 31) & 0x7fffffff;
+    y ^= (y >> 31) & 0x7fffffff;
+    return (x > y) - (x < y);
+}
+
+static int compare_double_bits(const void *a, const void *b) {
+    int64_t x, y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    x ^= (x >> 63) & 0x7fffffffffffffffLL;
+    y ^= (y >> 63) & 0x7fffffffffffffffLL;
+    return (x > y) - (x < y);
+}
+
+static int compare_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_uint64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// 64-bit keys: every other one from a small range (duplicates, negative as
+// int64), the rest from all 64 bits, so about half of those have bit 63 set
+static void fill_keys64(uint64_t *keys, long n, unsigned int *seed) {
+    for (long i = 0; i < n; i++) {
+        if (i % 2) {
+            keys[i] = (uint64_t)(int64_t)(rand_r(seed) % 2001 - 1000);
+        } else {
+            keys[i] = (uint64_t)rand_r(seed) << 33 ^ (uint64_t)rand_r(seed) << 11 ^
+                      (uint64_t)rand_r(seed);
+        }
+    }
+}
+
+// Records sorted by key, and each still carrying its payload: the value is
+// the record's index in keys, the input it was built from
+static int kv_payload_ok(const teamsort_kv_t *records, const int64_t *keys, long n) {
+    char *seen = calloc(n ? n : 1, 1);
+    if (!seen) return 0;
+    int ok = 1;
+    for (long i = 0; i < n && ok; i++) {
+        uint64_t from = records[i].value;
+        ok = from < (uint64_t)n && !seen[from] && records[i].key == keys[from] &&
+             (i == 0 || records[i - 1].key <= records[i].key);
+        if (ok) seen[from] = 1;
+    }
+    free(seen);
+    return ok;
+}
+
+// Odd and tiny sizes against qsort, with negative and duplicate keys
+void check_int32_sizes(teamsort_t *ts, const char *engine) {
+    long sizes[] = {0, 1, 3, 17, 1001, LARGE_N};
+    int32_t *keys = malloc(LARGE_N * sizeof(int32_t));
+    int32_t *expected = malloc(LARGE_N * sizeof(int32_t));
+    if (!keys || !expected) {
+        check(0, engine, "int32 buffers allocated");
+        free(keys);
+        free(expected);
+        return;
+    }
+    unsigned int seed = 434;
+    for (int s = 0; s < 6; s++) {
+        long n = sizes[s];
+        for (long i = 0; i < n; i++) {
+            keys[i] = (int32_t)(rand_r(&seed) % 2001) - 1000;
+        }
+        if (n > 1) {
+            keys[0] = INT32_MIN;
+            keys[n - 1] = INT32_MAX;
+        }
+        memcpy(expected, keys, n * sizeof(int32_t));
+        qsort(expected, n, sizeof(int32_t), compare_int32);
+        char what[64];
+        snprintf(what, sizeof(what), "int32 n=%ld sorted", n);
+        check(teamsort_int32(ts, keys, n) == 0 &&
+              memcmp(keys, expected, n * sizeof(int32_t)) == 0, engine, what);
+    }
+    free(keys);
+    free(expected);
+}
+
+// Every special value, repeated across a large odd job: NaNs of both signs
+// and payloads, infinities, signed zeros and subnormals
+void check_float_order(teamsort_t *ts, const char *engine) {
+    uint32_t specials[] = {
+        0x7fc00000, 0xffc00000, 0x7f800001, 0xff800001,    // NaNs
+        0x7f800000, 0xff800000, 0x00000000, 0x80000000,    // +-inf, +-0
+        0x00000001, 0x80000001, 0x3f800000, 0xbf800000     // Subnormals, +-1
+    };
+    int num_specials = sizeof(specials) / sizeof(specials[0]);
+    float *keys = malloc(LARGE_N * sizeof(float));
+    float *expected = malloc(LARGE_N * sizeof(float));
+    if (!keys || !expected) {
+        check(0, engine, "float buffers allocated");
+        free(keys);
+        free(expected);
+        return;
+    }
+    unsigned int seed = 434;
+    for (long i = 0; i < LARGE_N; i++) {
+        if (i % 7 == 0) {
+            memcpy(&keys[i], &specials[rand_r(&seed) % num_specials], sizeof(float));
+        } else {
+            keys[i] = (float)(rand_r(&seed) % 20001 - 10000) / 7.0f;
+        }
+    }
+    memcpy(expected, keys, LARGE_N * sizeof(float));
+    qsort(expected, LARGE_N, sizeof(float), compare_float_bits);
+    check(teamsort_float(ts, keys, LARGE_N) == 0 &&
+          memcmp(keys, expected, LARGE_N * sizeof(float)) == 0,
+          engine, "float totalOrder (NaN, inf, -0/+0)");
+    check(signbit(keys[0]) && isnan(keys[0]) && !signbit(keys[LARGE_N - 1]) && isnan(keys[LARGE_N - 1]),
+          engine, "float -NaN first, +NaN last");
+    free(keys);
+    free(expected);
+}
+
+void check_double_order(teamsort_t *ts, const char *engine) {
+    uint64_t specials[] = {
+        0x7ff8000000000000ULL, 0xfff8000000000000ULL, 0x7ff0000000000001ULL,
+        0x7ff0000000000000ULL, 0xfff0000000000000ULL,
+        0x0000000000000000ULL, 0x8000000000000000ULL,
+        0x0000000000000001ULL, 0x8000000000000001ULL
+    };
+    int num_specials = sizeof(specials) / sizeof(specials[0]);
+    double *keys = malloc(LARGE_N * sizeof(double));
+    double *expected = malloc(LARGE_N * sizeof(double));
+    if (!keys || !expected) {
+        check(0, engine, "double buffers allocated");
+        free(keys);
+        free(expected);
+        return;
+    }
+    unsigned int seed = 434;
+    for (long i = 0; i < LARGE_N; i++) {
+        if (i % 7 == 0) {
+            memcpy(&keys[i], &specials[rand_r(&seed) % num_specials], sizeof(double));
+        } else {
+            keys[i] = (double)(rand_r(&seed) % 20001 - 10000) / 7.0;
+        }
+    }
+    memcpy(expected, keys, LARGE_N * sizeof(double));
+    qsort(expected, LARGE_N, sizeof(double), compare_double_bits);
+    check(teamsort_double(ts, keys, LARGE_N) == 0 &&
+          memcmp(keys, expected, LARGE_N * sizeof(double)) == 0,
+          engine, "double totalOrder (NaN, inf, -0/+0)");
+    free(keys);
+    free(expected);
+}
+
+// Radix engine: a narrow key range takes the counting sort, the full
+// 32-bit range every LSD pass, and keys differing only in their high bits
+// skip the passes over the low ones
+void check_radix_shapes(teamsort_t *ts, const char *engine) {
+    int32_t *keys = malloc(LARGE_N * sizeof(int32_t));
+    int32_t *expected = malloc(LARGE_N * sizeof(int32_t));
+    if (!keys || !expected) {
+        check(0, engine, "radix buffers allocated");
+        free(keys);
+        free(expected);
+        return;
+    }
+    const char *names[] = {"narrow range", "full range", "high bits only"};
+    unsigned int seed = 434;
+    for (int shape = 0; shape < 3; shape++) {
+        for (long i = 0; i < LARGE_N; i++) {
+            uint32_t bits = (uint32_t)rand_r(&seed) << 16 ^ (uint32_t)rand_r(&seed);
+            if (shape == 0) keys[i] = (int32_t)(bits % 256) - 128;
+            else if (shape == 1) keys[i] = (int32_t)bits;
+            else keys[i] = (int32_t)(bits & 0x7f000000u);
+        }
+        memcpy(expected, keys, LARGE_N * sizeof(int32_t));
+        qsort(expected, LARGE_N, sizeof(int32_t), compare_int32);
+        teamsort_stats_t stats;
+        int result = teamsort_int32(ts, keys, LARGE_N);
+        teamsort_get_stats(ts, &stats);
+        char what[64];
+        snprintf(what, sizeof(what), "radix %s sorted", names[shape]);
+        check(result == 0 && memcmp(keys, expected, LARGE_N * sizeof(int32_t)) == 0, engine, what);
+        snprintf(what, sizeof(what), "radix %s takes the %s", names[shape],
+                 shape == 0 ? "counting sort" : "LSD passes");
+        check(stats.radix_mode != NULL && stats.radix_counting == (shape == 0), engine, what);
+        if (shape == 2) {
+            check(stats.radix_passes_skipped > 0, engine, "radix high bits only skip passes");
+        }
+    }
+    free(keys);
+    free(expected);
+}
+
+// Same sizes as int32, extremes at both ends
+void check_int64_order(teamsort_t *ts, const char *engine) {
+    long sizes[] = {0, 1, 3, 17, 1001, LARGE_N};
+    int64_t *keys = malloc(LARGE_N * sizeof(int64_t));
+    int64_t *expected = malloc(LARGE_N * sizeof(int64_t));
+    if (!keys || !expected) {
+        check(0, engine, "int64 buffers allocated");
+        free(keys);
+        free(expected);
+        return;
+    }
+    unsigned int seed = 434;
+    for (int s = 0; s < 6; s++) {
+        long n = sizes[s];
+        fill_keys64((uint64_t *)keys, n, &seed);
+        if (n > 1) {
+            keys[0] = INT64_MAX;
+            keys[n - 1] = INT64_MIN;
+        }
+        memcpy(expected, keys, n * sizeof(int64_t));
+        qsort(expected, n, sizeof(int64_t), compare_int64);
+        char what[64];
+        snprintf(what, sizeof(what), "int64 n=%ld sorted", n);
+        check(teamsort_int64(ts, keys, n) == 0 &&
+              memcmp(keys, expected, n * sizeof(int64_t)) == 0, engine, what);
+    }
+    free(keys);
+    free(expected);
+}
+
+// Keys with bit 63 set must sort above every key without it
+void check_uint64_order(teamsort_t *ts, const char *engine) {
+    long sizes[] = {0, 1, 3, 17, 1001, LARGE_N};
+    uint64_t *keys = malloc(LARGE_N * sizeof(uint64_t));
+    uint64_t *expected = malloc(LARGE_N * sizeof(uint64_t));
+    if (!keys || !expected) {
+        check(0, engine, "uint64 buffers allocated");
+        free(keys);
+        free(expected);
+        return;
+    }
+    unsigned int seed = 434;
+    for (int s = 0; s < 6; s++) {
+        long n = sizes[s];
+        fill_keys64(keys, n, &seed);
+        if (n > 2) {
+            keys[0] = UINT64_MAX;
+            keys[1] = 1ULL << 63;
+            keys[n - 1] = 0;
+        }
+        memcpy(expected, keys, n * sizeof(uint64_t));
+        qsort(expected, n, sizeof(uint64_t), compare_uint64);
+        char what[64];
+        snprintf(what, sizeof(what), "uint64 n=%ld sorted", n);
+        check(teamsort_uint64(ts, keys, n) == 0 &&
+              memcmp(keys, expected, n * sizeof(uint64_t)) == 0, engine, what);
+    }
+    free(keys);
+    free(expected);
+}
+
+void check_kv_payload(teamsort_t *ts, const char *engine) {
+    long sizes[] = {0, 1, 3, 17, 1001, LARGE_N};
+    teamsort_kv_t *records = malloc(LARGE_N * sizeof(teamsort_kv_t));
+    int64_t *keys = malloc(LARGE_N * sizeof(int64_t));
+    if (!records || !keys) {
+        check(0, engine, "kv buffers allocated");
+        free(records);
+        free(keys);
+        return;
+    }
+    unsigned int seed = 434;
+    for (int s = 0; s < 6; s++) {
+        long n = sizes[s];
+        fill_keys64((uint64_t *)keys, n, &seed);
+        for (long i = 0; i < n; i++) {
+            records[i].key = keys[i];
+            records[i].value = i;
+        }
+        char what[64];
+        snprintf(what, sizeof(what), "kv n=%ld sorted, payloads with their keys", n);
+        check(teamsort_kv(ts, records, n) == 0 && kv_payload_ok(records, keys, n), engine, what);
+    }
+    free(records);
+    free(keys);
+}
+
+// One batch of every type, on a context with the default small-job
+// threshold: the large job runs on the engine, the others on one thread each
+void check_mixed_batch(teamsort_t *ts, const char *engine) {
+    int32_t *int32_keys = malloc(1001 * sizeof(int32_t));
+    int64_t *int64_keys = malloc(LARGE_N * sizeof(int64_t));
+    uint64_t *uint64_keys = malloc(17 * sizeof(uint64_t));
+    float *float_keys = malloc(3 * sizeof(float));
+    double *double_keys = malloc(1001 * sizeof(double));
+    teamsort_kv_t *records = malloc(1001 * sizeof(teamsort_kv_t));
+    int64_t *kv_keys = malloc(1001 * sizeof(int64_t));
+    int32_t *int32_expected = malloc(1001 * sizeof(int32_t));
+    int64_t *int64_expected = malloc(LARGE_N * sizeof(int64_t));
+    uint64_t uint64_expected[17];
+    if (!int32_keys || !int64_keys || !uint64_keys || !float_keys || !double_keys ||
+        !records || !kv_keys || !int32_expected || !int64_expected) {
+        check(0, engine, "mixed batch buffers allocated");
+    } else {
+        unsigned int seed = 434;
+        for (long i = 0; i < 1001; i++) {
+            int32_keys[i] = (int32_t)(rand_r(&seed) % 2001) - 1000;
+            double_keys[i] = 1001 - i - 0.5;    // Descending
+        }
+        fill_keys64((uint64_t *)int64_keys, LARGE_N, &seed);
+        fill_keys64(uint64_keys, 17, &seed);
+        fill_keys64((uint64_t *)kv_keys, 1001, &seed);
+        for (long i = 0; i < 1001; i++) {
+            records[i].key = kv_keys[i];
+            records[i].value = i;
+        }
+        float_keys[0] = 1.0f;
+        float_keys[1] = -0.0f;
+        float_keys[2] = -1.0f;
+        memcpy(int32_expected, int32_keys, 1001 * sizeof(int32_t));
+        qsort(int32_expected, 1001, sizeof(int32_t), compare_int32);
+        memcpy(int64_expected, int64_keys, LARGE_N * sizeof(int64_t));
+        qsort(int64_expected, LARGE_N, sizeof(int64_t), compare_int64);
+        memcpy(uint64_expected, uint64_keys, sizeof(uint64_expected));
+        qsort(uint64_expected, 17, sizeof(uint64_t), compare_uint64);
+
+        teamsort_job_t jobs[] = {
+            {TEAMSORT_INT32, int32_keys, 1001},
+            {TEAMSORT_INT64, int64_keys, LARGE_N},
+            {TEAMSORT_UINT64, uint64_keys, 17},
+            {TEAMSORT_FLOAT, float_keys, 3},
+            {TEAMSORT_DOUBLE, double_keys, 1001},
+            {TEAMSORT_KV, records, 1001},
+            {TEAMSORT_INT32, NULL, 0}
+        };
+        int result = teamsort_sort(ts, jobs, sizeof(jobs) / sizeof(jobs[0]));
+        int sorted_doubles = 1;
+        for (long i = 1; i < 1001; i++) {
+            if (double_keys[i - 1] > double_keys[i]) sorted_doubles = 0;
+        }
+        check(result == 0 &&
+              memcmp(int32_keys, int32_expected, 1001 * sizeof(int32_t)) == 0 &&
+              memcmp(int64_keys, int64_expected, LARGE_N * sizeof(int64_t)) == 0 &&
+              memcmp(uint64_keys, uint64_expected, sizeof(uint64_expected)) == 0 &&
+              float_keys[0] == -1.0f && signbit(float_keys[1]) && float_keys[2] == 1.0f &&
+              sorted_doubles && kv_payload_ok(records, kv_keys, 1001),
+              engine, "mixed batch of every type sorted (small jobs on one thread)");
+    }
+    free(int32_keys);
+    free(int64_keys);
+    free(uint64_keys);
+    free(float_keys);
+    free(double_keys);
+    free(records);
+    free(kv_keys);
+    free(int32_expected);
+    free(int64_expected);
+}
+
+int main(void) {
+    int engines[] = {TEAMSORT_BITONIC, TEAMSORT_BLOCK, TEAMSORT_RADIX};
+    for (int e = 0; e < 3; e++) {
+        // small_job 1: every job runs on the parallel engine
+        teamsort_config_t config = {
+            NUM_THREADS, engines[e], SORT_BARRIER_FUTEX, -1, NULL, 1,
+            NULL, NULL, NULL, NULL
+        };
+        teamsort_t *ts = teamsort_create(&config);
+        if (!ts || teamsort_start(ts) != 0) {
+            printf("[ERROR] Failed to start %d sort threads: %s\n", NUM_THREADS, strerror(errno));
+            return 1;
+        }
+        const char *engine = teamsort_engine_name(engines[e]);
+        check_job_limits(ts, engine);
+        check_int32_sizes(ts, engine);
+        check_float_order(ts, engine);
+        check_double_order(ts, engine);
+        check_int64_order(ts, engine);
+        check_uint64_order(ts, engine);
+        check_kv_payload(ts, engine);
+        if (engines[e] == TEAMSORT_RADIX) {
+            check_radix_shapes(ts, engine);
+        }
+        teamsort_destroy(ts);
+
+        // small_job 0: the default threshold
+        config.small_job = 0;
+        ts = teamsort_create(&config);
+        if (!ts || teamsort_start(ts) != 0) {
+            printf("[ERROR] Failed to start %d sort threads: %s\n", NUM_THREADS, strerror(errno));
+            return 1;
+        }
+        check_mixed_batch(ts, engine);
+        teamsort_destroy(ts);
+    }
+
+    printf("[TEST] %s\n", failures ? "Some checks FAILED" : "All checks PASSED");
+    return failures ? 1 : 0;
+}
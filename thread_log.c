@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "thread_log.h"
+
+#define LOG_WRAP 0xffffffffu    // Record length: the rest of the ring is unused
+
+// Ring contents: records of a header and the line, padded to 8 bytes
+typedef struct {
+    unsigned long long seq;
+    unsigned int len;
+    unsigned int unused;
+} log_record_t;
+
+// One thread's ring. The owning thread is the only producer and writes
+// head; the writer is the only consumer and writes tail. Both count bytes.
+typedef struct {
+    unsigned long head __attribute__((aligned(64)));
+    unsigned long tail __attribute__((aligned(64)));
+    char data[THREAD_LOG_RING] __attribute__((aligned(64)));
+} log_ring_t;
+
+// A drained line waiting to be written
+typedef struct {
+    unsigned long long seq;
+    size_t offset;          // Into text
+    unsigned int len;
+} log_line_t;
+
+static int log_level = THREAD_LOG_INFO;
+static log_ring_t **rings = NULL;
+static int ring_count = 0;
+static int rings_used = 0;
+static unsigned long long next_seq = 0;
+
+static pthread_t writer;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static int writer_running = 0;
+static int writer_stop = 0;
+static int held = 0;
+
+// Drained, not yet written (grown by the writer under writer_lock)
+static log_line_t *lines = NULL;
+static size_t num_lines = 0, max_lines = 0;
+static char *text = NULL;
+static size_t text_used = 0, text_size = 0;
+
+// my_ring_failed: no ring left for this thread, it prints directly
+static __thread log_ring_t *my_ring = NULL;
+static __thread int my_ring_failed = 0;
+
+static const char *level_names[] = {"quiet", "info", "debug"};
+
+int thread_log_parse(const char *name) {
+    for (int level = THREAD_LOG_QUIET; level <= THREAD_LOG_DEBUG; level++) {
+        if (strcmp(name, level_names[level]) == 0) return level;
+    }
+    return -1;
+}
+
+const char *thread_log_level_name(int level) {
+    return level >= THREAD_LOG_QUIET && level <= THREAD_LOG_DEBUG ? level_names[level] : "unknown";
+}
+
+static unsigned long padded(unsigned long len) {
+    return (len + 7) & ~7UL;
+}
+
+// The calling thread's ring, allocated on first use. NULL if none is left.
+static log_ring_t *claim_ring(void) {
+    if (my_ring || my_ring_failed) return my_ring;
+    int index = __atomic_fetch_add(&rings_used, 1, __ATOMIC_ACQ_REL);
+    void *memory;
+    if (index >= ring_count || posix_memalign(&memory, 64, sizeof(log_ring_t)) != 0) {
+        my_ring_failed = 1;
+        return NULL;
+    }
+    log_ring_t *ring = memory;
+    ring->head = ring->tail = 0;
+    __atomic_store_n(&rings[index], ring, __ATOMIC_RELEASE);
+    my_ring = ring;
+    return ring;
+}
+
+void thread_log(int level, const char *format, ...) {
+    if (level > log_level) return;
+    va_list args;
+    log_ring_t *ring = NULL;
+    if (__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) {
+        ring = claim_ring();
+    }
+    if (!ring) {
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+
+    char line[THREAD_LOG_LINE];
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len < 0) return;
+    if (len >= THREAD_LOG_LINE) len = THREAD_LOG_LINE - 1;
+
+    // A record never wraps: if it does not fit before the end of the ring,
+    // the rest is skipped
+    unsigned long need = sizeof(log_record_t) + padded(len);
+    unsigned long head = ring->head;
+    unsigned long offset = head & (THREAD_LOG_RING - 1);
+    unsigned long to_end = THREAD_LOG_RING - offset;
+    unsigned long claim = need <= to_end ? need : to_end + need;
+    struct timespec pause = {0, THREAD_LOG_POLL_NS / 10};
+    while (head + claim - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > THREAD_LOG_RING) {
+        nanosleep(&pause, NULL);
+    }
+    if (claim != need) {
+        if (to_end >= sizeof(log_record_t)) {
+            ((log_record_t *)(ring->data + offset))->len = LOG_WRAP;
+        }
+        offset = 0;
+    }
+
+    log_record_t *record = (log_record_t *)(ring->data + offset);
+    record->seq = __atomic_fetch_add(&next_seq, 1, __ATOMIC_RELAXED);
+    record->len = len;
+    memcpy(record + 1, line, len);
+    __atomic_store_n(&ring->head, head + claim, __ATOMIC_RELEASE);
+}
+
+// Append one line to the drained ones. Returns 0, or -1 if out of memory.
+static int keep_line(unsigned long long seq, const char *line, unsigned int len) {
+    if (num_lines == max_lines) {
+        size_t max = max_lines ? 2 * max_lines : 1024;
+        log_line_t *grown = realloc(lines, max * sizeof(log_line_t));
+        if (!grown) return -1;
+        lines = grown;
+        max_lines = max;
+    }
+    if (text_used + len > text_size) {
+        size_t size = text_size ? 2 * text_size : 65536;
+        while (size < text_used + len) size *= 2;
+        char *grown = realloc(text, size);
+        if (!grown) return -1;
+        text = grown;
+        text_size = size;
+    }
+    memcpy(text + text_used, line, len);
+    lines[num_lines].seq = seq;
+    lines[num_lines].offset = text_used;
+    lines[num_lines].len = len;
+    num_lines++;
+    text_used += len;
+    return 0;
+}
+
+static int compare_lines(const void *a, const void *b) {
+    unsigned long long x = ((const log_line_t *)a)->seq;
+    unsigned long long y = ((const log_line_t *)b)->seq;
+    return (x > y) - (x < y);
+}
+
+// Write the drained lines in sequence order. Holding writer_lock.
+static void write_lines(void) {
+    if (num_lines == 0) return;
+    qsort(lines, num_lines, sizeof(log_line_t), compare_lines);
+    for (size_t i = 0; i < num_lines; i++) {
+        fwrite(text + lines[i].offset, 1, lines[i].len, stdout);
+    }
+    fflush(stdout);
+    num_lines = 0;
+    text_used = 0;
+}
+
+// Take everything the rings hold. Holding writer_lock.
+static void drain_rings(void) {
+    int used = __atomic_load_n(&rings_used, __ATOMIC_ACQUIRE);
+    if (used > ring_count) used = ring_count;
+    for (int r = 0; r < used; r++) {
+        log_ring_t *ring = __atomic_load_n(&rings[r], __ATOMIC_ACQUIRE);
+        if (!ring) continue;
+        unsigned long tail = ring->tail;
+        unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        while (tail != head) {
+            unsigned long offset = tail & (THREAD_LOG_RING - 1);
+            unsigned long to_end = THREAD_LOG_RING - offset;
+            const log_record_t *record = (const log_record_t *)(ring->data + offset);
+            if (to_end < sizeof(log_record_t) || record->len == LOG_WRAP) {
+                tail += to_end;
+                continue;
+            }
+            // Out of memory: write what is held to make room
+            if (keep_line(record->seq, (const char *)(record + 1), record->len) != 0) {
+                write_lines();
+                if (keep_line(record->seq, (const char *)(record + 1), record->len) != 0) {
+                    fwrite(record + 1, 1, record->len, stdout);
+                }
+            }
+            tail += sizeof(log_record_t) + padded(record->len);
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    struct timespec poll = {0, THREAD_LOG_POLL_NS};
+    for (;;) {
+        int stopping = __atomic_load_n(&writer_stop, __ATOMIC_ACQUIRE);
+        pthread_mutex_lock(&writer_lock);
+        drain_rings();
+        if (!held || stopping) write_lines();
+        pthread_mutex_unlock(&writer_lock);
+        if (stopping) break;
+        nanosleep(&poll, NULL);
+    }
+    return NULL;
+}
+
+// exit() while lines are held or in the rings: write them first
+static void write_at_exit(void) {
+    if (!__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) return;
+    pthread_mutex_lock(&writer_lock);
+    drain_rings();
+    write_lines();
+    pthread_mutex_unlock(&writer_lock);
+}
+
+int thread_log_start(int level, int max_threads) {
+    static int exit_registered = 0;
+    log_level = level;
+    if (max_threads <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    rings = calloc(max_threads, sizeof(log_ring_t *));
+    if (!rings) return -1;
+    ring_count = max_threads;
+    rings_used = 0;
+    writer_stop = 0;
+    held = 0;
+
+    int result = pthread_create(&writer, NULL, writer_main, NULL);
+    if (result != 0) {
+        free(rings);
+        rings = NULL;
+        ring_count = 0;
+        errno = result;
+        return -1;
+    }
+    if (!exit_registered) {
+        atexit(write_at_exit);
+        exit_registered = 1;
+    }
+    __atomic_store_n(&writer_running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void thread_log_hold(void) {
+    pthread_mutex_lock(&writer_lock);
+    held = 1;
+    pthread_mutex_unlock(&writer_lock);
+}
+
+void thread_log_release(void) {
+    pthread_mutex_lock(&writer_lock);
+    held = 0;
+    if (writer_running) {
+        drain_rings();
+        write_lines();
+    }
+    pthread_mutex_unlock(&writer_lock);
+}
+
+void thread_log_stop(void) {
+    if (!writer_running) return;
+    __atomic_store_n(&writer_running, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&writer_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+    free(lines);
+    free(text);
+    lines = NULL;
+    text = NULL;
+    num_lines = max_lines = text_used = text_size = 0;
+}
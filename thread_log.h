@@ -0,0 +1,52 @@
+#ifndef THREAD_LOG_H
+#define THREAD_LOG_H
+
+// Leveled, buffered logging for the per-thread progress lines.
+//
+// A line at or below the configured level is formatted on the calling
+// thread into its own single-producer/single-consumer byte ring (allocated
+// on the thread's first line, found through thread-local storage) and
+// stamped with a global sequence number. No stdio, no lock. A writer
+// thread drains all rings every THREAD_LOG_POLL_NS, orders the lines by
+// sequence number and writes them to stdout in one batch. A full ring
+// makes its producer wait for the writer, so no line is lost.
+//
+// thread_log_hold keeps the writer from writing until thread_log_release,
+// which writes everything held before it returns: a run can keep stdout
+// quiet while the sort is timed and print its progress afterwards.
+//
+// Before thread_log_start and after thread_log_stop, lines are printed
+// directly. Not async-signal-safe.
+
+#define THREAD_LOG_QUIET 0      // Nothing but what the program prints itself
+#define THREAD_LOG_INFO  1      // Progress of main, teams and signals
+#define THREAD_LOG_DEBUG 2      // Every thread's lines
+
+#define THREAD_LOG_RING 1024            // Bytes per thread, power of 2
+#define THREAD_LOG_LINE 256             // Longer lines are cut
+#define THREAD_LOG_POLL_NS 1000000L     // Writer drain interval
+
+// "quiet", "info" or "debug" -> level, -1 if unknown
+int thread_log_parse(const char *name);
+
+const char *thread_log_level_name(int level);
+
+// Set the level and start the writer for up to max_threads logging
+// threads (more print directly). Call from a thread with signals blocked
+// (the writer inherits its mask). Returns 0, or -1 with errno set.
+int thread_log_start(int level, int max_threads);
+
+// Log a printf-style line (with its own '\n') if level is enabled
+void thread_log(int level, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+void thread_log_hold(void);
+
+// Write what is held and let the writer write again
+void thread_log_release(void);
+
+// Write everything logged so far and stop the writer. Call when the other
+// logging threads are done; later lines are printed directly.
+void thread_log_stop(void);
+
+#endif
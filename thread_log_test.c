@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "thread_log.h"
+
+// Checks for thread_log, run by make test_quick. stdout is pointed at a
+// pipe while lines are logged, so the checks can see exactly what the
+// writer has written and when; results go to the original stdout.
+
+#define NUM_THREADS 4
+#define LINES_PER_THREAD 200    // Several rings' worth: producers must wait for the writer
+
+int failures = 0;
+int saved_stdout;
+int pipe_read;
+
+// Function declarations
+void check(int ok, const char *what);
+size_t read_written(char *buffer, size_t size);
+void *log_lines(void *arg);
+int lines_in_order(const char *text, size_t len);
+
+void check(int ok, const char *what) {
+    dprintf(saved_stdout, "[TEST] thread_log: %s: %s\n", what, ok ? "PASSED" : "FAILED");
+    if (!ok) failures++;
+}
+
+// Everything the writer has written so far, after giving it a few polls
+size_t read_written(char *buffer, size_t size) {
+    struct timespec settle = {0, 20 * THREAD_LOG_POLL_NS};
+    nanosleep(&settle, NULL);
+    fflush(stdout);
+    size_t used = 0;
+    for (;;) {
+        ssize_t got = read(pipe_read, buffer + used, size - 1 - used);
+        if (got <= 0) break;
+        used += got;
+    }
+    buffer[used] = '\0';
+    return used;
+}
+
+void *log_lines(void *arg) {
+    int thread_id = *(int *)arg;
+    for (int i = 0; i < LINES_PER_THREAD; i++) {
+        thread_log(THREAD_LOG_INFO, "[LINE] %d %d\n", thread_id, i);
+        thread_log(THREAD_LOG_DEBUG, "[DEBUG] %d %d\n", thread_id, i);
+    }
+    return NULL;
+}
+
+// Every thread's lines all present, each thread's in the order logged
+int lines_in_order(const char *text, size_t len) {
+    int next[NUM_THREADS] = {0};
+    const char *line = text;
+    while (line < text + len) {
+        int thread_id, i;
+        if (sscanf(line, "[LINE] %d %d", &thread_id, &i) != 2 ||
+            thread_id < 0 || thread_id >= NUM_THREADS || i != next[thread_id]) {
+            return 0;
+        }
+        next[thread_id]++;
+        const char *end = strchr(line, '\n');
+        if (!end) return 0;
+        line = end + 1;
+    }
+    for (int t = 0; t < NUM_THREADS; t++) {
+        if (next[t] != LINES_PER_THREAD) return 0;
+    }
+    return 1;
+}
+
+int main(void) {
+    int fds[2];
+    saved_stdout = dup(STDOUT_FILENO);
+    if (saved_stdout < 0 || pipe(fds) != 0 || fcntl(fds[0], F_SETFL, O_NONBLOCK) != 0 ||
+        dup2(fds[1], STDOUT_FILENO) < 0) {
+        printf("[ERROR] Failed to capture stdout: %s\n", strerror(errno));
+        return 1;
+    }
+    close(fds[1]);
+    pipe_read = fds[0];
+    // The held lines must fit in the pipe, or the release would block
+    static char buffer[65536];
+
+    if (thread_log_start(THREAD_LOG_INFO, NUM_THREADS + 1) != 0) {
+        dprintf(saved_stdout, "[ERROR] Failed to start the log writer: %s\n", strerror(errno));
+        return 1;
+    }
+    thread_log_hold();
+    pthread_t threads[NUM_THREADS];
+    int ids[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) {
+        ids[t] = t;
+        if (pthread_create(&threads[t], NULL, log_lines, &ids[t]) != 0) {
+            dprintf(saved_stdout, "[ERROR] Failed to create thread %d\n", t);
+            return 1;
+        }
+    }
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    check(read_written(buffer, sizeof(buffer)) == 0, "nothing written while held");
+
+    thread_log_release();
+    size_t len = read_written(buffer, sizeof(buffer));
+    check(!strstr(buffer, "[DEBUG]"), "debug lines dropped at info");
+    check(lines_in_order(buffer, len), "held lines written at release, in order");
+
+    thread_log(THREAD_LOG_INFO, "[LINE] after release\n");
+    read_written(buffer, sizeof(buffer));
+    check(strcmp(buffer, "[LINE] after release\n") == 0, "lines written as they come after release");
+
+    thread_log_hold();
+    thread_log(THREAD_LOG_INFO, "[LINE] held at stop\n");
+    thread_log_stop();
+    read_written(buffer, sizeof(buffer));
+    check(strcmp(buffer, "[LINE] held at stop\n") == 0, "held lines written at stop");
+
+    dprintf(saved_stdout, "[TEST] %s\n", failures ? "Some checks FAILED" : "All checks PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "thread_trace.h"
+
+typedef struct {
+    unsigned long long stamp;
+    const char *name;
+    int arg;
+    char type;
+} trace_event_t;
+
+typedef struct {
+    int group;
+    int tid;                // Track id: registration order
+    char name[48];
+    long count;             // Claimed slots, may pass capacity
+    trace_event_t events[];
+} trace_buffer_t;
+
+static trace_buffer_t **buffers = NULL;
+static int max_buffers = 0;
+static int num_buffers = 0;
+static long capacity = 0;
+static char group_names[THREAD_TRACE_MAX_GROUPS][48];
+static unsigned long long start_stamp;
+static long long start_ns;
+static __thread trace_buffer_t *my_buffer = NULL;
+
+static long long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static inline unsigned long long read_stamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return (unsigned long long)now_ns();
+#endif
+}
+
+int thread_trace_start(int max_threads, long events_per_thread) {
+    if (max_threads <= 0 || events_per_thread <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    buffers = calloc(max_threads, sizeof(trace_buffer_t *));
+    if (!buffers) return -1;
+    max_buffers = max_threads;
+    num_buffers = 0;
+    capacity = events_per_thread;
+    memset(group_names, 0, sizeof(group_names));
+    start_ns = now_ns();
+    start_stamp = read_stamp();
+    return 0;
+}
+
+int thread_trace_register(int group, const char *name) {
+    if (!buffers) return 0;
+    if (group < 0 || group >= THREAD_TRACE_MAX_GROUPS) {
+        errno = EINVAL;
+        return -1;
+    }
+    trace_buffer_t *buffer = malloc(sizeof(trace_buffer_t) + capacity * sizeof(trace_event_t));
+    if (!buffer) return -1;
+    int slot = __atomic_fetch_add(&num_buffers, 1, __ATOMIC_RELAXED);
+    if (slot >= max_buffers) {
+        free(buffer);
+        errno = ENOSPC;
+        return -1;
+    }
+    buffer->group = group;
+    buffer->tid = slot;
+    snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+    buffer->count = 0;
+    __atomic_store_n(&buffers[slot], buffer, __ATOMIC_RELEASE);
+    my_buffer = buffer;
+    return 0;
+}
+
+void thread_trace_event(char type, const char *name, int arg) {
+    trace_buffer_t *buffer = my_buffer;
+    if (!buffer) return;
+    long slot = __atomic_fetch_add(&buffer->count, 1, __ATOMIC_RELAXED);
+    if (slot >= capacity) return;
+    trace_event_t *event = &buffer->events[slot];
+    event->stamp = read_stamp();
+    event->name = name;
+    event->arg = arg;
+    event->type = type;
+}
+
+void thread_trace_name_group(int group, const char *name) {
+    if (group >= 0 && group < THREAD_TRACE_MAX_GROUPS) {
+        snprintf(group_names[group], sizeof(group_names[group]), "%s", name);
+    }
+}
+
+static int compare_stamps(const void *a, const void *b) {
+    const trace_event_t *x = a, *y = b;
+    if (x->stamp != y->stamp) return x->stamp < y->stamp ? -1 : 1;
+    // Same stamp: an end closes before the next begin opens
+    return (x->type == THREAD_TRACE_END ? 0 : 1) - (y->type == THREAD_TRACE_END ? 0 : 1);
+}
+
+static void write_string(FILE *file, const char *text) {
+    fputc('"', file);
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') fputc('\\', file);
+        fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+long thread_trace_write(const char *path, long *dropped) {
+    *dropped = 0;
+    if (!buffers) return 0;
+    FILE *file = fopen(path, "w");
+    if (!file) return -1;
+
+    // Stamps to microseconds since the start; without a TSC they are
+    // already nanoseconds
+    double ns_per_tick = 1.0;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned long long end_stamp = read_stamp();
+    long long end_ns = now_ns();
+    if (end_stamp > start_stamp) {
+        ns_per_tick = (double)(end_ns - start_ns) / (end_stamp - start_stamp);
+    }
+#endif
+    int registered = __atomic_load_n(&num_buffers, __ATOMIC_ACQUIRE);
+    if (registered > max_buffers) registered = max_buffers;
+
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    long written = 0;
+    int first = 1;
+    int group_named[THREAD_TRACE_MAX_GROUPS] = {0};
+    for (int b = 0; b < registered; b++) {
+        trace_buffer_t *buffer = __atomic_load_n(&buffers[b], __ATOMIC_ACQUIRE);
+        if (!buffer) continue;
+        long count = buffer->count < capacity ? buffer->count : capacity;
+        if (buffer->count > capacity) *dropped += buffer->count - capacity;
+        qsort(buffer->events, count, sizeof(trace_event_t), compare_stamps);
+
+        // Metadata: process (group) and thread names, tracks in team order
+        if (!group_named[buffer->group] && group_names[buffer->group][0]) {
+            fprintf(file, "%s{\"ph\": \"M\", \"pid\": %d, \"name\": \"process_name\", "
+                          "\"args\": {\"name\": ", first ? "" : ",\n", buffer->group);
+            write_string(file, group_names[buffer->group]);
+            fprintf(file, "}},\n{\"ph\": \"M\", \"pid\": %d, \"name\": \"process_sort_index\", "
+                          "\"args\": {\"sort_index\": %d}}", buffer->group, buffer->group);
+            group_named[buffer->group] = 1;
+            first = 0;
+        }
+        fprintf(file, "%s{\"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"name\": \"thread_name\", "
+                      "\"args\": {\"name\": ", first ? "" : ",\n", buffer->group, buffer->tid);
+        write_string(file, buffer->name);
+        fprintf(file, "}},\n{\"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+                      "\"name\": \"thread_sort_index\", \"args\": {\"sort_index\": %d}}",
+                buffer->group, buffer->tid, buffer->tid);
+        first = 0;
+
+        for (long i = 0; i < count; i++) {
+            const trace_event_t *event = &buffer->events[i];
+            double us = (long long)(event->stamp - start_stamp) * ns_per_tick / 1e3;
+            fprintf(file, ",\n{\"ph\": \"%c\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"name\": ",
+                    event->type, buffer->group, buffer->tid, us);
+            write_string(file, event->name);
+            if (event->type == THREAD_TRACE_INSTANT) {
+                fprintf(file, ", \"s\": \"t\"");
+            }
+            if (event->arg >= 0) {
+                fprintf(file, ", \"args\": {\"arg\": %d}", event->arg);
+            }
+            fputc('}', file);
+            written++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    if (fclose(file) != 0) return -1;
+    return written;
+}
+
+void thread_trace_stop(void) {
+    if (!buffers) return;
+    for (int b = 0; b < max_buffers; b++) {
+        free(buffers[b]);
+    }
+    free(buffers);
+    buffers = NULL;
+    max_buffers = num_buffers = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef THREAD_TRACE_H
+#define THREAD_TRACE_H
+
+// Per-thread timeline tracing, written out as Chrome trace-event JSON
+// (chrome://tracing, ui.perfetto.dev).
+//
+// Each thread registers once and gets a fixed-size event buffer of its
+// own, found through thread-local storage, so recording takes no lock: one
+// timestamp and one slot claimed with an atomic add, which also keeps a
+// signal handler that interrupts the thread mid-record from reusing its
+// slot. thread_trace_event is async-signal-safe. A full buffer drops
+// further events and counts them.
+//
+// On x86 the stamps are TSC reads, converted to CLOCK_MONOTONIC time with
+// the rate measured between thread_trace_start and thread_trace_write
+// (constant-rate TSC assumed); elsewhere they are CLOCK_MONOTONIC reads.
+//
+// Threads are grouped into processes in the trace: every thread gives a
+// group id (e.g. its team, used as the trace's pid) and a name when it
+// registers, and the groups get names before the trace is written, so
+// each team becomes one block of tracks.
+
+#define THREAD_TRACE_BEGIN   'B'
+#define THREAD_TRACE_END     'E'
+#define THREAD_TRACE_INSTANT 'i'
+
+#define THREAD_TRACE_MAX_GROUPS 64
+
+// Allocate the buffer table for up to max_threads threads of
+// events_per_thread events each (buffers are allocated as threads
+// register). Returns 0, or -1 with errno set.
+int thread_trace_start(int max_threads, long events_per_thread);
+
+// Give the calling thread a buffer. group is in [0, THREAD_TRACE_MAX_GROUPS);
+// name is copied. Returns 0, or -1 with errno set (ENOSPC: every slot is
+// taken). Does nothing and returns 0 when tracing was not started.
+int thread_trace_register(int group, const char *name);
+
+// Record a begin, end or instant event named name (a string that stays
+// valid until the trace is written) on the calling thread's track. arg is
+// shown with the event unless negative. No-op for unregistered threads.
+void thread_trace_event(char type, const char *name, int arg);
+
+// Name a group (e.g. "Team 0") in the trace
+void thread_trace_name_group(int group, const char *name);
+
+// Write every buffer to path, with events sorted by time per thread.
+// Call after the traced threads are done. Returns the number of events
+// written, or -1 with errno set; *dropped gets the events lost to full
+// buffers.
+long thread_trace_write(const char *path, long *dropped);
+
+// Free the buffers
+void thread_trace_stop(void);
+
+#endif
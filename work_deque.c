@@ -0,0 +1,73 @@
+#include <stdlib.h>
+#include <errno.h>
+#include "work_deque.h"
+
+int work_deque_init(work_deque_t *deque, long capacity) {
+    long size = 1;
+    while (size < capacity) size <<= 1;
+    deque->tasks = malloc(size * sizeof(ws_task_t));
+    if (!deque->tasks) {
+        errno = ENOMEM;
+        return -1;
+    }
+    deque->mask = size - 1;
+    deque->top = 0;
+    deque->bottom = 0;
+    return 0;
+}
+
+void work_deque_destroy(work_deque_t *deque) {
+    free(deque->tasks);
+    deque->tasks = NULL;
+}
+
+int work_deque_push(work_deque_t *deque, const ws_task_t *task) {
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    if (bottom - top > deque->mask) {
+        return -1;
+    }
+    deque->tasks[bottom & deque->mask] = *task;
+    // Publish the slot before the new bottom
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// Reserve the bottom slot first, then look at top: if a thief got there
+// too, the CAS on top decides who takes the last task
+int work_deque_pop(work_deque_t *deque, ws_task_t *task) {
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if (top > bottom) {
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    *task = deque->tasks[bottom & deque->mask];
+    if (top < bottom) {
+        return 1;
+    }
+    int won = __atomic_compare_exchange_n(&deque->top, &top, top + 1, 0,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return won;
+}
+
+int work_deque_steal(work_deque_t *deque, ws_task_t *task) {
+    long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom) {
+        return 0;
+    }
+    ws_task_t stolen = deque->tasks[top & deque->mask];
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return -1;
+    }
+    *task = stolen;
+    return 1;
+}
@@ -0,0 +1,43 @@
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+// Chase-Lev work-stealing deque of sort tasks.
+//
+// The owning thread pushes and pops at the bottom (LIFO, so it keeps
+// working on the most recently split, cache-warm ranges); any other thread
+// steals from the top (FIFO, so thieves take the oldest and usually largest
+// ranges). Only the race for the last task goes through a CAS. The ring
+// has a fixed capacity: a full deque rejects the push and the owner runs
+// the task itself, which keeps thieves from ever reading a slot that is
+// being overwritten.
+
+typedef struct {
+    int group;      // Team whose subarray the range belongs to
+    int low;
+    int high;
+    int depth;      // Partitioning levels left before heapsort
+} ws_task_t;
+
+typedef struct {
+    long top __attribute__((aligned(64)));
+    long bottom __attribute__((aligned(64)));
+    ws_task_t *tasks;
+    long mask;      // Capacity - 1, capacity is a power of 2
+} work_deque_t;
+
+// Returns 0 on success, -1 with errno set on failure. capacity is rounded
+// up to a power of 2.
+int work_deque_init(work_deque_t *deque, long capacity);
+void work_deque_destroy(work_deque_t *deque);
+
+// Owner only. Returns 0, or -1 if the deque is full.
+int work_deque_push(work_deque_t *deque, const ws_task_t *task);
+
+// Owner only. Returns 1 and fills task, or 0 if the deque is empty.
+int work_deque_pop(work_deque_t *deque, ws_task_t *task);
+
+// Any thread. Returns 1 and fills task, 0 if the deque is empty, or -1 if
+// another thread won the race for the top task.
+int work_deque_steal(work_deque_t *deque, ws_task_t *task);
+
+#endif